@@ -0,0 +1,277 @@
+/*	================================================================
+	BinaryIndexedTree(http://en.wikipedia.org/wiki/Fenwick_tree),
+	also known as Fenwick tree, maintains prefix sums of a sequence
+	under point updates, in O(logN) for both.
+
+	Keys are 1-based: a tree of size N holds the values of keys
+	1, 2, ..., N. The Value type needs operator+=, operator- and a
+	zero given by Value(0).
+
+	================================================================
+
+	Usage:
+
+		vector<int> counts;
+		his::BinaryIndexedTree<size_t, int> tree(begin(counts), end(counts));
+
+		tree.Add(key, 1);						// counts[key-1] += 1
+		int prefix = tree.Accumulate(key);		// counts[0] + ... + counts[key-1]
+		size_t key = tree.LowerBound(prefix);	// inverse of Accumulate
+
+	RangeBinaryIndexedTree adds a value to a range of keys at once:
+
+		his::RangeBinaryIndexedTree<size_t, int> tree(size);
+		tree.RangeAdd(first, last, 1);			// keys [first, last]
+		int sum = tree.RangeSum(first, last);
+
+	================================================================
+
+	Build time: O(N)
+	Update/Query time: O(logN)
+	Space Complexity: O(N)
+
+	Notes:
+	LowerBound assumes all values are non-negative, so that prefix
+	sums are sorted. It is the usual way to sample an index with
+	probability proportional to its weight, or to find the k-th
+	element of a multiset stored as counts.
+*/
+
+#ifndef HIS_DATASTRUCTURE_BINARYINDEXEDTREE_H
+#define HIS_DATASTRUCTURE_BINARYINDEXEDTREE_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace his
+{
+
+
+template<typename Key, typename Value>
+class BinaryIndexedTree
+{
+public:
+	/*
+	Input:
+	size_t size: Number of keys, all values start with 0.
+	*/
+	explicit BinaryIndexedTree(size_t size) : m_tree(size + 1, Value(0))
+	{}
+
+	/*
+	Inputs:
+	const Iter begin, const Iter end:
+		Two stl iterators giving the values of keys 1, 2, ..., N.
+
+	Each node is pushed once to its parent, the build is O(N).
+	*/
+	template<class Iter>
+	BinaryIndexedTree(const Iter begin, const Iter end) : m_tree(1, Value(0))
+	{
+		for (auto it = begin; it != end; ++it)
+			m_tree.push_back(*it);
+
+		for (size_t i = 1; i < m_tree.size(); ++i)
+		{
+			size_t parent = i + last_bit(i);
+			if (parent < m_tree.size())
+				m_tree[parent] += m_tree[i];
+		}
+	}
+
+	size_t Size() const { return m_tree.size() - 1; }
+
+	void Add(Key key, Value val)
+	{
+		assert(key > 0 && size_t(key) <= Size());
+		for (size_t i = size_t(key); i < m_tree.size(); i += last_bit(i))
+			m_tree[i] += val;
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [1, key], 0 if key is 0.
+	*/
+	Value Accumulate(Key key) const
+	{
+		assert(size_t(key) <= Size());
+		Value acc = Value(0);
+		for (size_t i = size_t(key); i > 0; i -= last_bit(i))
+			acc += m_tree[i];
+		return acc;
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [first, last].
+	*/
+	Value RangeSum(Key first, Key last) const
+	{
+		assert(first > 0);
+		return Accumulate(last) - Accumulate(first - 1);
+	}
+
+	/*
+	Output:
+	The value of a single key. Only the part of the path below the
+	common ancestor of key and key-1 is walked, instead of two
+	complete prefix queries.
+	*/
+	Value Get(Key key) const
+	{
+		assert(key > 0 && size_t(key) <= Size());
+		size_t i = size_t(key);
+		Value val = m_tree[i];
+		size_t stop = i - last_bit(i);
+		for (--i; i != stop; i -= last_bit(i))
+			val = val - m_tree[i];
+		return val;
+	}
+
+	void Set(Key key, Value val)
+	{
+		Add(key, val - Get(key));
+	}
+
+	/*
+	Input:
+	Value prefix: The prefix sum to search for.
+
+	Output:
+	The smallest key such that Accumulate(key) >= prefix, or Size()+1
+	if there is none. All values must be non-negative.
+
+	A single descent from the highest power of 2, O(logN).
+	*/
+	Key LowerBound(Value prefix) const
+	{
+		size_t pos = 0;
+		size_t mask = 1;
+		while (mask * 2 <= Size())
+			mask *= 2;
+
+		for (; mask > 0; mask /= 2)
+		{
+			if (pos + mask <= Size() && m_tree[pos + mask] < prefix)
+			{
+				pos += mask;
+				prefix = prefix - m_tree[pos];
+			}
+		}
+		return Key(pos + 1);
+	}
+
+private:
+	static size_t last_bit(size_t i)
+	{
+		return i & (~i + 1);
+	}
+	std::vector<Value> m_tree;
+};
+
+
+/*
+	A pair of binary indexed trees on the differences of the sequence,
+	supporting adding a value to a range of keys and summing a range
+	of keys, both in O(logN). Keys are 1-based as well.
+
+	With d the difference sequence, the prefix sum up to key k is
+		sum_{i<=k} d[i] * (k - i + 1) = k * sum(d[i]) - sum(d[i] * (i-1))
+	which are two ordinary prefix sums.
+*/
+template<typename Key, typename Value>
+class RangeBinaryIndexedTree
+{
+public:
+	explicit RangeBinaryIndexedTree(size_t size)
+		: m_diff(size), m_weighted(size)
+	{}
+
+	/*
+	Inputs:
+	const Iter begin, const Iter end:
+		Two stl iterators giving the initial values of keys 1, 2, ..., N.
+	*/
+	template<class Iter>
+	RangeBinaryIndexedTree(const Iter begin, const Iter end)
+		: RangeBinaryIndexedTree(differences(begin, end, false), 
+			differences(begin, end, true))
+	{}
+
+	size_t Size() const { return m_diff.Size(); }
+
+	/*
+	Add val to all keys in [first, last].
+	*/
+	void RangeAdd(Key first, Key last, Value val)
+	{
+		assert(first > 0 && first <= last && size_t(last) <= Size());
+		m_diff.Add(first, val);
+		m_weighted.Add(first, val * Value(first - 1));
+		if (size_t(last) < Size())
+		{
+			m_diff.Add(last + 1, Value(0) - val);
+			m_weighted.Add(last + 1, Value(0) - val * Value(last));
+		}
+	}
+
+	void Add(Key key, Value val)
+	{
+		RangeAdd(key, key, val);
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [1, key], 0 if key is 0.
+	*/
+	Value Accumulate(Key key) const
+	{
+		return m_diff.Accumulate(key) * Value(key) - m_weighted.Accumulate(key);
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [first, last].
+	*/
+	Value RangeSum(Key first, Key last) const
+	{
+		assert(first > 0);
+		return Accumulate(last) - Accumulate(first - 1);
+	}
+
+	Value Get(Key key) const
+	{
+		return m_diff.Accumulate(key);
+	}
+
+private:
+	// difference sequence d[i] = a[i] - a[i-1], or d[i] * (i-1)
+	template<class Iter>
+	static std::vector<Value> differences(const Iter begin, const Iter end, bool weighted)
+	{
+		std::vector<Value> diff;
+		Value prev = Value(0);
+		for (auto it = begin; it != end; ++it)
+		{
+			Value cur = *it;
+			Value d = cur - prev;
+			diff.push_back(weighted ? d * Value(diff.size()) : d);
+			prev = cur;
+		}
+		return diff;
+	}
+
+	// both trees are built with the O(N) iterator constructor
+	RangeBinaryIndexedTree(const std::vector<Value> &diff, const std::vector<Value> &weighted)
+		: m_diff(diff.begin(), diff.end())
+		, m_weighted(weighted.begin(), weighted.end())
+	{}
+
+	BinaryIndexedTree<Key, Value> m_diff;
+	BinaryIndexedTree<Key, Value> m_weighted;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_BINARYINDEXEDTREE_H
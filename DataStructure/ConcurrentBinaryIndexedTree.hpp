@@ -0,0 +1,248 @@
+/*	================================================================
+	A BinaryIndexedTree (see BinaryIndexedTree.hpp) that many threads
+	can Add to at the same time, without a lock.
+
+	The tree has atomic nodes, and there are two ways to add to it:
+
+	1) Add on the tree itself walks up the nodes with relaxed atomic
+	   fetch-adds. It is thread safe as is, but every call touches
+	   logN shared cache lines, which is slower than a plain tree even
+	   without contention.
+
+	2) A Writer, one per thread, buffers the additions in a private
+	   array of plain values, one per key: an Add is a single
+	   non-atomic increment. Every `batch` additions (and when the
+	   Writer is destroyed) the buffer is flushed: the dense buffer is
+	   turned into tree nodes in O(N), like the O(N) build of
+	   BinaryIndexedTree, and each nonzero node is added atomically
+	   once. A small batch is flushed key by key instead. The writers
+	   share no cache line between flushes, so they scale with the
+	   number of threads.
+
+	Use Writers for heavy concurrent counting, and Add on the tree for
+	occasional updates.
+
+	================================================================
+
+	Usage:
+
+		his::ConcurrentBinaryIndexedTree<size_t, int> histogram(bins);
+
+		// in any number of worker threads
+		his::ConcurrentBinaryIndexedTree<size_t, int>::Writer writer(histogram);
+		for (...)
+			writer.Add(bin, 1);
+		// flushed when the writer goes out of scope, or by writer.Flush()
+
+		// once the workers are done
+		int count = histogram.Accumulate(bin);
+
+	================================================================
+
+	Update time:
+		Add: O(logN) atomic operations
+		Writer::Add: O(1) amortized, with the default batch of N
+	Query time: O(logN)
+	Space Complexity: O(N) for the tree, plus O(N + batch) for every
+		live Writer, so O(S*N) with S writing threads.
+
+	Notes:
+	Accumulate and Get can run concurrently with the additions, but then
+	only see some of them, and never the ones still buffered in a
+	Writer. The result is exact at any quiescent point (after the
+	writers are flushed and the threads joined, or otherwise
+	synchronized with the reader).
+*/
+
+#ifndef HIS_DATASTRUCTURE_CONCURRENTBINARYINDEXEDTREE_H
+#define HIS_DATASTRUCTURE_CONCURRENTBINARYINDEXEDTREE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace his
+{
+
+
+template<typename Key, typename Value>
+class ConcurrentBinaryIndexedTree
+{
+public:
+	/*
+	Input:
+	size_t size: Number of keys, all values start with 0.
+	*/
+	explicit ConcurrentBinaryIndexedTree(size_t size)
+		: m_size(size), m_tree(new std::atomic<Value>[size + 1])
+	{
+		for (size_t i = 0; i <= size; ++i)
+			m_tree[i].store(Value(0), std::memory_order_relaxed);
+	}
+
+	size_t Size() const { return m_size; }
+
+	/*
+	Thread safe, lock free.
+	*/
+	void Add(Key key, Value val)
+	{
+		assert(key > 0 && size_t(key) <= m_size);
+		for (size_t i = size_t(key); i <= m_size; i += last_bit(i))
+			fetch_add(m_tree[i], val);
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [1, key].
+	*/
+	Value Accumulate(Key key) const
+	{
+		assert(size_t(key) <= m_size);
+		Value acc = Value(0);
+		for (size_t i = size_t(key); i > 0; i -= last_bit(i))
+			acc += m_tree[i].load(std::memory_order_relaxed);
+		return acc;
+	}
+
+	/*
+	Output:
+	Sum of the values of keys [first, last].
+	*/
+	Value RangeSum(Key first, Key last) const
+	{
+		assert(first > 0);
+		return Accumulate(last) - Accumulate(first - 1);
+	}
+
+	Value Get(Key key) const
+	{
+		return RangeSum(key, key);
+	}
+
+	/*
+	The buffered writer of one thread, see above. It must not outlive
+	the tree, and is used by a single thread at a time.
+	*/
+	class Writer
+	{
+	public:
+		/*
+		Inputs:
+		ConcurrentBinaryIndexedTree &tree: The tree to add to.
+		size_t batch: Number of additions between flushes, 0 for N.
+		*/
+		explicit Writer(ConcurrentBinaryIndexedTree &tree, size_t batch = 0)
+			: m_tree(&tree), m_delta(tree.Size() + 1, Value(0))
+			, m_batch(batch > 0 ? batch : (tree.Size() > 0 ? tree.Size() : 1))
+		{
+			m_keys.reserve(m_batch);
+		}
+
+		// the moved-from writer has nothing left to flush
+		Writer(Writer &&other)
+			: m_tree(other.m_tree), m_delta(std::move(other.m_delta))
+			, m_keys(std::move(other.m_keys)), m_batch(other.m_batch)
+		{
+			other.m_tree = nullptr;
+		}
+		Writer(const Writer &) = delete;
+		Writer &operator=(const Writer &) = delete;
+
+		~Writer()
+		{
+			if (m_tree)
+				Flush();
+		}
+
+		void Add(Key key, Value val)
+		{
+			assert(key > 0 && size_t(key) <= m_tree->Size());
+			m_delta[size_t(key)] += val;
+			m_keys.push_back(size_t(key));
+			if (m_keys.size() >= m_batch)
+				Flush();
+		}
+
+		/*
+		Publish the buffered additions to the tree.
+		*/
+		void Flush()
+		{
+			const size_t size = m_tree->Size();
+			size_t depth = 1;
+			while ((size_t(1) << depth) <= size)
+				++depth;
+
+			if (m_keys.size() * depth < size)
+			{
+				// few keys, walk up from each one
+				for (size_t key : m_keys)
+				{
+					if (m_delta[key] == Value(0))
+						continue;
+					m_tree->Add(Key(key), m_delta[key]);
+					m_delta[key] = Value(0);
+				}
+			}
+			else
+			{
+				// dense, push every node to its parent once, then publish
+				for (size_t i = 1; i <= size; ++i)
+				{
+					size_t parent = i + last_bit(i);
+					if (parent <= size)
+						m_delta[parent] += m_delta[i];
+				}
+				for (size_t i = 1; i <= size; ++i)
+				{
+					if (m_delta[i] != Value(0))
+						fetch_add(m_tree->m_tree[i], m_delta[i]);
+					m_delta[i] = Value(0);
+				}
+			}
+			m_keys.clear();
+		}
+
+	private:
+		ConcurrentBinaryIndexedTree *m_tree;
+		std::vector<Value> m_delta;			// pending additions, by key
+		std::vector<size_t> m_keys;			// keys added since the last flush
+		size_t m_batch;
+	};
+
+private:
+	static size_t last_bit(size_t i)
+	{
+		return i & (~i + 1);
+	}
+
+	// native atomic add for integers
+	template<typename T>
+	static typename std::enable_if<std::is_integral<T>::value>::type
+		fetch_add(std::atomic<T> &node, T val)
+	{
+		node.fetch_add(val, std::memory_order_relaxed);
+	}
+
+	// compare and swap loop for the other types (float, double, ...)
+	template<typename T>
+	static typename std::enable_if<!std::is_integral<T>::value>::type
+		fetch_add(std::atomic<T> &node, T val)
+	{
+		T old = node.load(std::memory_order_relaxed);
+		while (!node.compare_exchange_weak(old, old + val, std::memory_order_relaxed))
+			;
+	}
+
+	size_t m_size;
+	std::unique_ptr<std::atomic<Value>[]> m_tree;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_CONCURRENTBINARYINDEXEDTREE_H
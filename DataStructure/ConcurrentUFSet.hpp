@@ -0,0 +1,192 @@
+/*	================================================================
+	A lock-free union-find set (see UFSet.hpp), where any number of
+	threads can Merge and Find at the same time.
+
+	Parent links are only changed with compare-and-swap:
+	1) Merge links the root with the larger index under the root
+	   with the smaller one (union by index). A failed CAS means the
+	   root was linked by another thread, the Merge then retries from
+	   the new roots.
+	2) Find halves the path on its way up, a failed CAS is simply
+	   ignored since another thread already shortened the path.
+
+	Every link points to a smaller index, so there are never cycles,
+	and the root of a set is always its smallest element, no matter
+	how the threads interleave. Reduce labels the sets in the order
+	of their roots, hence the labels are deterministic and identical
+	to the ones of UFSet::Reduce.
+
+	================================================================
+
+	Usage:
+
+		his::ConcurrentUFSet sets(pixels);
+
+		// in any number of threads
+		sets.Merge(p, q);
+
+		// once the merging threads are done
+		int regions = sets.Reduce(threads);
+		int region_of_p = sets.Query(p);
+
+	================================================================
+
+	Merge/Find time: lock-free, short paths in practice thanks to halving
+	Reduce time: O(N/threads + threads)
+	Space Complexity: 4 bytes per element, 4 more after Reduce
+
+	Notes:
+	Reduce must not run concurrently with Merge. Merging can go on
+	after a Reduce, another Reduce is then needed for Query.
+*/
+
+#ifndef HIS_DATASTRUCTURE_CONCURRENTUFSET_H
+#define HIS_DATASTRUCTURE_CONCURRENTUFSET_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+class ConcurrentUFSet
+{
+public:
+	ConcurrentUFSet(size_t size)
+		: m_size(size), m_parent(new std::atomic<uint32_t>[size])
+	{
+		assert(size < UINT32_MAX);
+		for (size_t i = 0; i < size; ++i)
+			m_parent[i].store(uint32_t(i), std::memory_order_relaxed);
+	}
+
+	size_t Size() const { return m_size; }
+
+	/*
+	Join the sets of id1 and id2. Thread safe, lock free.
+	Output:
+		true if they were in different sets.
+	*/
+	bool Merge(size_t id1, size_t id2)
+	{
+		uint32_t root1 = Find(id1);
+		uint32_t root2 = Find(id2);
+		while (root1 != root2)
+		{
+			// the larger root goes under the smaller one
+			uint32_t small = root1 < root2 ? root1 : root2;
+			uint32_t large = root1 < root2 ? root2 : root1;
+			uint32_t expected = large;
+			if (m_parent[large].compare_exchange_strong(expected, small,
+				std::memory_order_acq_rel))
+				return true;
+
+			// large was linked meanwhile, start again from the roots
+			root1 = Find(small);
+			root2 = Find(large);
+		}
+		return false;
+	}
+
+	/*
+	Output:
+		The root of the set of id, which is the smallest element of the
+		set at the time of the call. Thread safe, lock free.
+	*/
+	uint32_t Find(size_t id)
+	{
+		uint32_t i = uint32_t(id);
+		while (true)
+		{
+			uint32_t parent = m_parent[i].load(std::memory_order_acquire);
+			if (parent == i)
+				return i;
+
+			// path halving, skip to the grandparent if nobody else did
+			uint32_t grandparent = m_parent[parent].load(std::memory_order_acquire);
+			if (grandparent != parent)
+				m_parent[i].compare_exchange_weak(parent, grandparent,
+					std::memory_order_acq_rel);
+			i = grandparent;
+		}
+	}
+
+	/*
+	Output:
+		The id of the set of element id, valid after Reduce.
+	*/
+	int Query(size_t id) const
+	{
+		return int(m_label[id]);
+	}
+
+	/*
+	Label the sets with dense ids in [0, M), ordered by their first
+	element. Each thread flattens and counts the roots of its chunk,
+	then an exclusive scan of the counts gives every chunk its first
+	label.
+	Input:
+		int threads: Number of threads, 0 for all cores.
+	Output:
+		M, the number of sets.
+	*/
+	int Reduce(int threads = 1)
+	{
+		m_label.resize(m_size);
+		int chunks = thread_count(threads, m_size);
+		std::vector<uint32_t> roots(chunks + 1, 0);
+
+		// link everything directly to its root, count roots per chunk
+		parallel_chunks(size_t(0), m_size, chunks, [&](int chunk, size_t b, size_t e)
+		{
+			uint32_t count = 0;
+			for (size_t i = b; i < e; ++i)
+			{
+				uint32_t root = Find(i);
+				m_parent[i].store(root, std::memory_order_relaxed);
+				count += (root == i);
+			}
+			roots[chunk + 1] = count;
+		});
+
+		// exclusive scan, roots[chunk] is the first label of the chunk
+		for (int chunk = 0; chunk < chunks; ++chunk)
+			roots[chunk + 1] += roots[chunk];
+
+		// roots precede the other elements of their set, label them first
+		parallel_chunks(size_t(0), m_size, chunks, [&](int chunk, size_t b, size_t e)
+		{
+			uint32_t label = roots[chunk];
+			for (size_t i = b; i < e; ++i)
+				if (m_parent[i].load(std::memory_order_relaxed) == i)
+					m_label[i] = label++;
+		});
+
+		parallel_chunks(size_t(0), m_size, chunks, [&](int, size_t b, size_t e)
+		{
+			for (size_t i = b; i < e; ++i)
+			{
+				uint32_t root = m_parent[i].load(std::memory_order_relaxed);
+				if (root != i)
+					m_label[i] = m_label[root];
+			}
+		});
+
+		return int(roots[chunks]);
+	}
+
+private:
+	size_t m_size;
+	std::unique_ptr<std::atomic<uint32_t>[]> m_parent;
+	std::vector<uint32_t> m_label;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_CONCURRENTUFSET_H
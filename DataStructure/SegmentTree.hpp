@@ -19,6 +19,11 @@
 		ValueType(ValueType, ValueType), or any equivalent versions.
 		Usually defined by a lambda expression.
 
+		For heavy value types (strings, vectors, histograms), the
+		operation can be given in place instead, with signature
+		void(ValueType &acc, const ValueType &rhs), doing acc = acc op rhs.
+		No temporaries are created then, see the notes below.
+
 	4) An identity element(e)
 		\any a \in D, a op e == e op a == a
 
@@ -40,6 +45,13 @@
 		for (size_t i = start; i < end; ++i)
 			sum_from_start_to_end += values[i];
 
+	For many queries at once, since the tree is read-only after the
+	construction:
+
+		vector<pair<size_t, size_t>> ranges;
+		vector<int> sums;
+		segment_tree.query_batch(ranges, sums, threads);
+
 	================================================================
 	
 	Build time: O(N)
@@ -51,15 +63,28 @@
 	of size N, a full binary tree will be built with 2^(cell(logN)+1)-1
 	nodes, which wastes memories. If you use this on a space consuming 
 	user-defined type, that might be a problem.
+
+	Internally every operation is done in place: a node is built by
+	copying its left child into the node storage and accumulating the
+	right child, and a query accumulates the covering nodes from left
+	to right into a single result. A value returning operation is 
+	called as acc = op(std::move(acc), rhs), an in place one directly.
+	The query(start, end, result) version reuses the storage of the
+	caller's result as well.
 */
 
 #ifndef HIS_DATASTRUCTURE_SEGMENTTREE_H
 #define HIS_DATASTRUCTURE_SEGMENTTREE_H
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "../Miscellaneous/Parallel.hpp"
+
 namespace his
 {
 
@@ -67,7 +92,7 @@ namespace his
 template<typename ValueType>
 class SegmentTree
 {
-	typedef std::function<ValueType(ValueType, ValueType)> Operation;
+	typedef std::function<void(ValueType &, const ValueType &)> Accumulation;
 
 public:
 	/*
@@ -82,25 +107,33 @@ public:
 		holds for any value of ValueType.
 		For aesthetic reason I put this parameter before operation.
 
-	Operation operation:
+	Func operation:
 		A functor with type: ValueType(ValueType, ValueType) 
 		or any equivalent versions, defining the binary operation.
+		Or a functor with type: void(ValueType &, const ValueType &)
+		accumulating the right hand side into the left one.
+
+	int threads:
+		Number of threads to build the internal nodes with, 0 for all
+		cores. The operation may be called concurrently.
 	*/
-	template<class Iter>
+	template<class Iter, class Func>
 	SegmentTree(const Iter begin, const Iter end, 
-		ValueType identity, Operation operation)
-		:m_identity(identity), m_operation(operation)
+		ValueType identity, Func operation, int threads = 1)
+		:m_identity(identity), m_accumulate(make_accumulation(operation, 0))
 	{
 		// an optimistic check
-		assert(m_operation(identity, identity) == identity);
+		ValueType check = identity;
+		m_accumulate(check, identity);
+		assert(check == identity);
 
 		// count the element number
-		int size = 0;
+		size_t size = 0;
 		for (auto it = begin; it != end; ++it)
 			size++;
 
 		// expand to full binary tree, number of leaves must be a 2-power
-		int leaves = 1;
+		size_t leaves = 1;
 		while (leaves < size)
 			leaves *= 2;
 
@@ -110,15 +143,26 @@ public:
 		// put leaves to the end
 		size_t pos = leaves-1; // beginning of the leaves
 		for (auto it = begin; it != end; ++it)
-			m_tree[pos++] = *it;
+			m_tree[pos++].value = *it;
 
 		// fill with identities
 		while (pos < m_tree.size())
-			m_tree[pos++] = m_identity;
-
-		// initialize internal nodes
-		for (int i = leaves-2; i >= 0; --i)
-			m_tree[i] = m_operation(m_tree[get_left_child(i)], m_tree[get_right_child(i)]);
+			m_tree[pos++].value = m_identity;
+
+		// initialize internal nodes, level by level from the bottom,
+		// nodes of the same level [width-1, width*2-1) are independent
+		for (size_t width = leaves / 2; width > 0; width /= 2)
+		{
+			parallel_for(width - 1, width * 2 - 1, 
+				width < s_parallel_grain ? 1 : threads, [&](size_t b, size_t e)
+			{
+				for (size_t i = b; i < e; ++i)
+				{
+					m_tree[i].value = m_tree[get_left_child(i)].value;
+					m_accumulate(m_tree[i].value, m_tree[get_right_child(i)].value);
+				}
+			});
+		}
 	}
 
 	/*
@@ -134,36 +178,175 @@ public:
 	for (size_t i = start; i < end; ++i)
 		accumulation = operation(accumulation, the_set[i]);
 	*/
-	ValueType query(size_t start, size_t end)
+	ValueType query(size_t start, size_t end) const
 	{
-		return query(start, end, 0, (m_tree.size()+1) / 2, 0);
+		ValueType result = m_identity;
+		accumulate(start, end, 0, (m_tree.size()+1) / 2, 0, result);
+		return result;
+	}
+
+	/*
+	Inputs:
+	size_t start, size_t end:
+	The query range [start, end)
+
+	ValueType &result:
+	Receives the accumulation from start to end(exclusive). Its storage
+	is reused, so querying repeatedly into the same variable does not 
+	allocate once it is large enough.
+	*/
+	void query(size_t start, size_t end, ValueType &result) const
+	{
+		result = m_identity;
+		accumulate(start, end, 0, (m_tree.size()+1) / 2, 0, result);
+	}
+
+	/*
+	Inputs:
+	const std::vector<std::pair<size_t, size_t>> &ranges:
+		The query ranges, each one [first, second).
+	std::vector<ValueType> &results:
+		Resized to ranges.size(), results[i] receives query(ranges[i]).
+	int threads:
+		Number of threads to share the batch, 0 for all cores.
+
+	The queries are answered in the order of their ranges rather than
+	the given order, so that consecutive queries walk similar paths 
+	and hit the cache. The nodes of the next query are prefetched.
+	*/
+	void query_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		std::vector<ValueType> &results, int threads = 1) const
+	{
+		results.resize(ranges.size());
+
+		std::vector<size_t> order(ranges.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+		{
+			return ranges[a] < ranges[b];
+		});
+
+		answer_batch(ranges, order, results, threads, std::is_same<ValueType, bool>());
 	}
 
 private:
+	// below this width a level of the tree is built in a single thread
+	static const size_t s_parallel_grain = 1 << 14;
+
 	// accessing children/parent indices in an array representation
-	size_t get_left_child(size_t id) { return id * 2 + 1; }
-	size_t get_right_child(size_t id) { return id * 2 + 2; }
-	size_t get_parent(size_t id) { return (id - 1) / 2; }
+	static size_t get_left_child(size_t id) { return id * 2 + 1; }
+	static size_t get_right_child(size_t id) { return id * 2 + 2; }
+	static size_t get_parent(size_t id) { return (id - 1) / 2; }
+
+	// the answers are written in place
+	void answer_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		const std::vector<size_t> &order, std::vector<ValueType> &results, int threads,
+		std::false_type) const
+	{
+		for_each_query(ranges, order, threads, [&](size_t k, size_t start, size_t end)
+		{
+			query(start, end, results[k]);
+		});
+	}
 
-	ValueType query(size_t start, size_t end, size_t node_start, size_t node_end, size_t node_id)
+	// std::vector<bool> packs bits, its neighbouring elements cannot be
+	// written concurrently, so the answers are gathered in bytes first
+	void answer_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		const std::vector<size_t> &order, std::vector<ValueType> &results, int threads,
+		std::true_type) const
 	{
-		// node range is inside query
-		if (start <= node_start && node_end <= end)
-			return m_tree[node_id];
+		std::vector<char> answers(ranges.size());
+		for_each_query(ranges, order, threads, [&](size_t k, size_t start, size_t end)
+		{
+			answers[k] = query(start, end);
+		});
+		std::copy(answers.begin(), answers.end(), results.begin());
+	}
+
+	// answer(k, start, end) over the queries in the sorted order
+	template<class Func>
+	void for_each_query(const std::vector<std::pair<size_t, size_t>> &ranges,
+		const std::vector<size_t> &order, int threads, Func answer) const
+	{
+		size_t leaves = (m_tree.size()+1) / 2;
+		parallel_for(size_t(0), order.size(), threads, [&](size_t b, size_t e)
+		{
+			for (size_t i = b; i < e; ++i)
+			{
+				if (i + 1 < e)
+				{
+					const std::pair<size_t, size_t> &next = ranges[order[i + 1]];
+					if (next.first < next.second && next.second <= leaves)
+					{
+						prefetch(&m_tree[leaves - 1 + next.first]);
+						prefetch(&m_tree[leaves - 2 + next.second]);
+					}
+				}
+
+				const std::pair<size_t, size_t> &range = ranges[order[i]];
+				answer(order[i], range.first, range.second);
+			}
+		});
+	}
 
+	static void prefetch(const void *address)
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
+	// in place operation, used as is
+	template<class Func>
+	static auto make_accumulation(Func operation, int)
+		-> typename std::enable_if<std::is_void<decltype(operation(
+			std::declval<ValueType &>(), std::declval<const ValueType &>()))>::value,
+			Accumulation>::type
+	{
+		return operation;
+	}
+
+	// value returning operation, the accumulator is moved in and out
+	template<class Func>
+	static Accumulation make_accumulation(Func operation, long)
+	{
+		return [operation](ValueType &acc, const ValueType &rhs)
+		{
+			acc = operation(std::move(acc), rhs);
+		};
+	}
+
+	// accumulate the nodes covering the query into acc, from left to right
+	void accumulate(size_t start, size_t end, size_t node_start, size_t node_end, size_t node_id,
+		ValueType &acc) const
+	{
 		// node range is outside query
 		if (end <= node_start || node_end <= start)
-			return m_identity;
+			return;
+
+		// node range is inside query
+		if (start <= node_start && node_end <= end)
+		{
+			m_accumulate(acc, m_tree[node_id].value);
+			return;
+		}
 
 		// query children with higher resolution
-		int mid = (node_start + node_end) / 2;
-		return m_operation(query(start, end, node_start, mid, get_left_child(node_id)),
-			query(start, end, mid, node_end, get_right_child(node_id)));
+		size_t mid = (node_start + node_end) / 2;
+		accumulate(start, end, node_start, mid, get_left_child(node_id), acc);
+		accumulate(start, end, mid, node_end, get_right_child(node_id), acc);
 	}
 
 	ValueType m_identity;
-	std::vector<ValueType> m_tree;
-	Operation m_operation;
+	// a node is wrapped so that std::vector<bool> does not pack the
+	// nodes into bits: they are accumulated through references, and
+	// written concurrently by the parallel build
+	struct Node { ValueType value; };
+	std::vector<Node> m_tree;
+	Accumulation m_accumulate;
 };
 
 
@@ -0,0 +1,250 @@
+/*	================================================================
+	SparseTable(http://en.wikipedia.org/wiki/Range_minimum_query)
+	answers range accumulative queries on a static set in constant
+	time, for idempotent operations such as min, max, gcd, bitwise
+	and/or.
+
+	It has the same interface as SegmentTree, so one can be swapped
+	for the other: the operation is given either value returning or in
+	place, the build takes a number of threads, and queries are
+	answered one by one, into a caller's result, or as a batch. The
+	operation must satisfy everything required by SegmentTree (closure,
+	associativity, identity), and also:
+		c) Idempotence: a op a == a
+
+	The table stores, for every level k and position i, the
+	accumulation of the 2^k elements starting from i. Any range is
+	then covered by two overlapping ranges of the same level, and
+	idempotence makes the overlap harmless.
+
+	================================================================
+
+	Usage:
+
+		vector<int> values;
+		his::SparseTable<int> sparse_table(begin(values), end(values),
+			INT_MAX, [](int a, int b)->int { return std::min(a, b); });
+
+		int min_from_start_to_end = sparse_table.query(start, end);
+
+		vector<pair<size_t, size_t>> ranges;
+		vector<int> minima;
+		sparse_table.query_batch(ranges, minima, threads);
+
+	================================================================
+
+	Build time: O(NlogN)
+	Query time: O(1), exactly two table lookups and one operation.
+	Space Complexity: O(NlogN)
+*/
+
+#ifndef HIS_DATASTRUCTURE_SPARSETABLE_H
+#define HIS_DATASTRUCTURE_SPARSETABLE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+template<typename ValueType>
+class SparseTable
+{
+	typedef std::function<void(ValueType &, const ValueType &)> Accumulation;
+
+public:
+	/*
+	Inputs:
+	const Iter begin, const Iter end:
+		Two stl iterators to indicate the set.
+
+	ValueType identity:
+		An identity element of ValueType, returned by empty queries.
+
+	Func operation:
+		A functor with type: ValueType(ValueType, ValueType)
+		or any equivalent versions, defining the binary operation.
+		Or a functor with type: void(ValueType &, const ValueType &)
+		accumulating the right hand side into the left one.
+		It must be idempotent.
+
+	int threads:
+		Number of threads to build each level with, 0 for all cores.
+		The operation may be called concurrently.
+	*/
+	template<class Iter, class Func>
+	SparseTable(const Iter begin, const Iter end,
+		ValueType identity, Func operation, int threads = 1)
+		:m_identity(identity), m_accumulate(make_accumulation(operation, 0))
+	{
+		// an optimistic check
+		ValueType check = identity;
+		m_accumulate(check, identity);
+		assert(check == identity);
+
+		// level 0 is the set itself
+		for (auto it = begin; it != end; ++it)
+		{
+			m_table.push_back(Node());
+			m_table.back().value = *it;
+		}
+		m_size = m_table.size();
+		m_offsets.push_back(0);
+
+		// floor(log2(length)) for every possible query length
+		m_log.assign(m_size + 1, 0);
+		for (size_t length = 2; length <= m_size; ++length)
+			m_log[length] = m_log[length / 2] + 1;
+
+		// level k combines two halves of length 2^(k-1) from level k-1,
+		// the positions of a level are independent
+		for (size_t half = 1; half * 2 <= m_size; half *= 2)
+		{
+			size_t prev = m_offsets.back();
+			size_t count = m_size - half * 2 + 1;
+			m_offsets.push_back(m_table.size());
+			m_table.resize(m_table.size() + count);
+
+			Node *level = &m_table[m_offsets.back()];
+			const Node *lower = &m_table[prev];
+			parallel_for(size_t(0), count,
+				count < s_parallel_grain ? 1 : threads, [&](size_t b, size_t e)
+			{
+				for (size_t i = b; i < e; ++i)
+				{
+					level[i].value = lower[i].value;
+					m_accumulate(level[i].value, lower[i + half].value);
+				}
+			});
+		}
+	}
+
+	/*
+	Inputs:
+	size_t start, size_t end:
+	The query range [start, end)
+
+	Output:
+	The accumulation of operation from start to end(exclusive).
+	*/
+	ValueType query(size_t start, size_t end) const
+	{
+		ValueType result = m_identity;
+		query(start, end, result);
+		return result;
+	}
+
+	/*
+	Inputs:
+	size_t start, size_t end:
+	The query range [start, end)
+
+	ValueType &result:
+	Receives the accumulation from start to end(exclusive), reusing its
+	storage.
+	*/
+	void query(size_t start, size_t end, ValueType &result) const
+	{
+		if (start >= end)
+		{
+			result = m_identity;
+			return;
+		}
+
+		assert(end <= m_size);
+		unsigned char level = m_log[end - start];
+		const Node *row = &m_table[m_offsets[level]];
+		result = row[start].value;
+		m_accumulate(result, row[end - (size_t(1) << level)].value);
+	}
+
+	/*
+	Inputs:
+	const std::vector<std::pair<size_t, size_t>> &ranges:
+		The query ranges, each one [first, second).
+	std::vector<ValueType> &results:
+		Resized to ranges.size(), results[i] receives query(ranges[i]).
+	int threads:
+		Number of threads to share the batch, 0 for all cores.
+
+	Every query is two lookups already, the batch is only split among
+	the threads.
+	*/
+	void query_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		std::vector<ValueType> &results, int threads = 1) const
+	{
+		results.resize(ranges.size());
+		answer_batch(ranges, results, threads, std::is_same<ValueType, bool>());
+	}
+
+private:
+	// below this count a level of the table is built in a single thread
+	static const size_t s_parallel_grain = 1 << 14;
+
+	// the answers are written in place
+	void answer_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		std::vector<ValueType> &results, int threads, std::false_type) const
+	{
+		parallel_for(size_t(0), ranges.size(), threads, [&](size_t b, size_t e)
+		{
+			for (size_t i = b; i < e; ++i)
+				query(ranges[i].first, ranges[i].second, results[i]);
+		});
+	}
+
+	// std::vector<bool> packs bits, its neighbouring elements cannot be
+	// written concurrently, so the answers are gathered in bytes first
+	void answer_batch(const std::vector<std::pair<size_t, size_t>> &ranges,
+		std::vector<ValueType> &results, int threads, std::true_type) const
+	{
+		std::vector<char> answers(ranges.size());
+		parallel_for(size_t(0), ranges.size(), threads, [&](size_t b, size_t e)
+		{
+			for (size_t i = b; i < e; ++i)
+				answers[i] = query(ranges[i].first, ranges[i].second);
+		});
+		std::copy(answers.begin(), answers.end(), results.begin());
+	}
+
+	// in place operation, used as is
+	template<class Func>
+	static auto make_accumulation(Func operation, int)
+		-> typename std::enable_if<std::is_void<decltype(operation(
+			std::declval<ValueType &>(), std::declval<const ValueType &>()))>::value,
+			Accumulation>::type
+	{
+		return operation;
+	}
+
+	// value returning operation, the accumulator is moved in and out
+	template<class Func>
+	static Accumulation make_accumulation(Func operation, long)
+	{
+		return [operation](ValueType &acc, const ValueType &rhs)
+		{
+			acc = operation(std::move(acc), rhs);
+		};
+	}
+
+	// wrapped so that std::vector<bool> does not pack the table into bits
+	struct Node { ValueType value; };
+
+	ValueType m_identity;
+	size_t m_size;
+	std::vector<Node> m_table;				// all levels, one after another
+	std::vector<size_t> m_offsets;			// beginning of each level in m_table
+	std::vector<unsigned char> m_log;		// floor(log2(length))
+	Accumulation m_accumulate;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_SPARSETABLE_H
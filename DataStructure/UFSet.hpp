@@ -0,0 +1,138 @@
+/*	================================================================
+	UFSet(http://en.wikipedia.org/wiki/Disjoint-set_data_structure),
+	a union-find set of the elements 0, 1, ..., N-1.
+
+	Merge joins the sets of two elements. Reduce then relabels all
+	the sets with dense ids 0, 1, ..., M-1, in the order of their
+	first element, and Query returns the id of an element's set.
+
+	Sets are joined by size (the smaller tree goes under the larger
+	root), and Find halves the path on its way up, so the trees stay
+	flat whatever the order of the merges.
+
+	================================================================
+
+	Usage:
+
+		his::UFSet sets(pixels);
+		sets.Merge(p, q);			// p and q are connected
+		...
+		int regions = sets.Reduce();
+		int region_of_p = sets.Query(p);
+
+	================================================================
+
+	Merge/Find time: O(alpha(N)) amortized, practically constant
+	Reduce time: O(N)
+	Space Complexity: 8 bytes per element
+
+	Notes:
+	Parents and sizes are 32-bit, N must be less than 2^32.
+*/
+
+#ifndef HIS_DATASTRUCTURE_UFSET_H
+#define HIS_DATASTRUCTURE_UFSET_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace his
+{
+
+
+class UFSet
+{
+public:
+	UFSet(size_t size) : m_parent(size), m_size(size, 1)
+	{
+		assert(size < UINT32_MAX);
+		for (size_t i = 0; i < size; ++i)
+			m_parent[i] = uint32_t(i);
+	}
+
+	size_t Size() const { return m_parent.size(); }
+
+	/*
+	Join the sets of id1 and id2.
+	Output:
+		true if they were in different sets.
+	*/
+	bool Merge(size_t id1, size_t id2)
+	{
+		uint32_t root1 = Find(id1);
+		uint32_t root2 = Find(id2);
+		if (root1 == root2)
+			return false;
+
+		if (m_size[root1] < m_size[root2])
+			std::swap(root1, root2);
+		m_parent[root2] = root1;
+		m_size[root1] += m_size[root2];
+		return true;
+	}
+
+	/*
+	Output:
+		The root (representative element) of the set of id.
+	*/
+	uint32_t Find(size_t id)
+	{
+		uint32_t i = uint32_t(id);
+		while (i != m_parent[i])
+		{
+			// path halving, every visited node skips its parent
+			m_parent[i] = m_parent[m_parent[i]];
+			i = m_parent[i];
+		}
+		return i;
+	}
+
+	/*
+	Output:
+		The id of the set of element id, valid after Reduce.
+	*/
+	int Query(size_t id) const
+	{
+		return int(m_parent[id]);
+	}
+
+	/*
+	Relabel the sets with dense ids in [0, M), ordered by their first
+	element. After this call the structure only answers Query.
+	Output:
+		M, the number of sets.
+	*/
+	int Reduce()
+	{
+		static const uint32_t NONE = UINT32_MAX;
+
+		// the sizes are no longer needed, they store the root labels
+		std::vector<uint32_t> &root_label = m_size;
+		for (size_t i = 0; i < root_label.size(); ++i)
+			root_label[i] = NONE;
+
+		// link everything directly to its root, labeling new roots
+		uint32_t labels = 0;
+		for (size_t i = 0; i < m_parent.size(); ++i)
+		{
+			uint32_t root = m_parent[i] = Find(i);
+			if (root_label[root] == NONE)
+				root_label[root] = labels++;
+		}
+
+		for (size_t i = 0; i < m_parent.size(); ++i)
+			m_parent[i] = root_label[m_parent[i]];
+		return int(labels);
+	}
+
+private:
+	std::vector<uint32_t> m_parent;
+	std::vector<uint32_t> m_size;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_UFSET_H
@@ -0,0 +1,166 @@
+/*	================================================================
+	WideSegmentTree is a cache friendly variant of SegmentTree, for
+	the same range accumulative operations on a static set (see
+	SegmentTree.hpp for the definition of the monoid: domain, set,
+	operation and identity).
+
+	Instead of a binary heap, it builds a B-ary tree, level by level.
+	The children of a node are stored contiguously, and B is chosen
+	so that they fill a cache line (16 ints, 8 doubles, etc.). A
+	query touches at most two blocks of B elements per level, and
+	there are only log_B(N) levels, so most of the cache misses of
+	a deep binary tree are gone.
+
+	Combining a block is a plain loop over contiguous values. If the
+	operation is given as a concrete functor type (std::plus<int>,
+	a lambda type, etc.) rather than the default std::function, the
+	compiler is able to inline and vectorize it.
+
+	================================================================
+
+	Usage:
+
+		vector<int> values;
+		his::WideSegmentTree<int> segment_tree(begin(values), end(values),
+			0, [](int a, int b)->int { return a + b; });
+
+		int sum_from_start_to_end = segment_tree.query(start, end);
+
+	With an inlinable operation:
+
+		his::WideSegmentTree<int, 16, std::plus<int>> segment_tree(
+			begin(values), end(values), 0, std::plus<int>());
+
+	================================================================
+
+	Build time: O(N)
+	Query time: O(B*log_B(N)) operations, O(log_B(N)) cache lines.
+	Space Complexity: O(N*B/(B-1))
+
+	Notes:
+	The operation is applied in the order of the set, so it does not
+	need to be commutative.
+*/
+
+#ifndef HIS_DATASTRUCTURE_WIDESEGMENTTREE_H
+#define HIS_DATASTRUCTURE_WIDESEGMENTTREE_H
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace his
+{
+
+
+template<typename ValueType,
+	size_t B = (64 / sizeof(ValueType) > 2 ? 64 / sizeof(ValueType) : 2),
+	class Operation = std::function<ValueType(ValueType, ValueType)> >
+class WideSegmentTree
+{
+	static_assert(B >= 2, "a B-ary tree needs at least two children per node");
+
+public:
+	/*
+	Inputs:
+	const Iter begin, const Iter end:
+		Two stl iterators to indicate the set.
+
+	ValueType identity:
+		An identity element of ValueType.
+
+	Operation operation:
+		A functor with type: ValueType(ValueType, ValueType)
+		or any equivalent versions, defining the binary operation.
+	*/
+	template<class Iter>
+	WideSegmentTree(const Iter begin, const Iter end,
+		ValueType identity, Operation operation)
+		:m_identity(identity), m_operation(operation)
+	{
+		// an optimistic check
+		assert(m_operation(identity, identity) == identity);
+
+		// level 0 holds the leaves, padded to a whole block
+		size_t size = 0;
+		for (auto it = begin; it != end; ++it)
+			size++;
+
+		m_nodes.resize(round_up(size), m_identity);
+		m_offsets.push_back(0);
+
+		size_t pos = 0;
+		for (auto it = begin; it != end; ++it)
+			m_nodes[pos++] = *it;
+
+		// every node of the next level combines one block of this level
+		while (size > B)
+		{
+			size_t offset = m_offsets.back();
+			size_t blocks = (size + B - 1) / B;
+
+			m_offsets.push_back(m_nodes.size());
+			m_nodes.resize(m_nodes.size() + round_up(blocks), m_identity);
+
+			for (size_t i = 0; i < blocks; ++i)
+				m_nodes[m_offsets.back() + i] = fold(&m_nodes[offset], i * B, (i + 1) * B);
+
+			size = blocks;
+		}
+	}
+
+	/*
+	Inputs:
+	size_t start, size_t end:
+	The query range [start, end)
+
+	Output:
+	The accumulation of operation from start to end(exclusive).
+	*/
+	ValueType query(size_t start, size_t end) const
+	{
+		ValueType left = m_identity, right = m_identity;
+		for (size_t level = 0; start < end; ++level)
+		{
+			const ValueType *nodes = &m_nodes[m_offsets[level]];
+
+			// whole blocks [first, last) are handled by the next level
+			size_t first = (start + B - 1) / B;
+			size_t last = end / B;
+			if (first >= last || level + 1 == m_offsets.size())
+			{
+				left = m_operation(left, fold(nodes, start, end));
+				break;
+			}
+
+			// partial blocks at both ends
+			left = m_operation(left, fold(nodes, start, first * B));
+			right = m_operation(fold(nodes, last * B, end), right);
+
+			start = first, end = last;
+		}
+		return m_operation(left, right);
+	}
+
+private:
+	static size_t round_up(size_t size) { return (size + B - 1) / B * B; }
+
+	// accumulate a contiguous range of nodes in a single level
+	ValueType fold(const ValueType *nodes, size_t start, size_t end) const
+	{
+		ValueType acc = m_identity;
+		for (size_t i = start; i < end; ++i)
+			acc = m_operation(acc, nodes[i]);
+		return acc;
+	}
+
+	ValueType m_identity;
+	std::vector<ValueType> m_nodes;		// all levels, leaves first
+	std::vector<size_t> m_offsets;		// beginning of each level in m_nodes
+	Operation m_operation;
+};
+
+
+}
+#endif // HIS_DATASTRUCTURE_WIDESEGMENTTREE_H
@@ -6,8 +6,26 @@
 
 #include "ImageProcessing/Foreach.hpp"
 #include "ImageProcessing/ForeachPair.hpp"
+#include "ImageProcessing/Reduce.hpp"
+#include "ImageProcessing/Histogram.hpp"
+#include "ImageProcessing/Find.hpp"
+#include "ImageProcessing/Convert.hpp"
 
 #include "ImageProcessing/IdxMap.hpp"
+#include "ImageProcessing/RunLengthMask.hpp"
+#include "ImageProcessing/CompactIdMap.hpp"
 #include "ImageProcessing/Filter.hpp"
+#include "ImageProcessing/FixedPointFilter.hpp"
+#include "ImageProcessing/FilterBank.hpp"
+#include "ImageProcessing/BilateralGrid.hpp"
+#include "ImageProcessing/RecursiveGaussian.hpp"
+#include "ImageProcessing/MedianFilter.hpp"
+#include "ImageProcessing/Morphology.hpp"
+#include "ImageProcessing/Convolution.hpp"
+#include "ImageProcessing/DistanceTransform.hpp"
+#include "ImageProcessing/Pyramid.hpp"
+#include "ImageProcessing/Remap.hpp"
+
+#include "ImageProcessing/ConnectedComponents.hpp"
 
 #endif // HIS_IMAGEPROCESSING_H
\ No newline at end of file
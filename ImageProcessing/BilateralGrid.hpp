@@ -0,0 +1,290 @@
+/*	================================================================
+	A fast approximation of the bilateral filter through the bilateral
+	grid of J. Chen, S. Paris and F. Durand, "Real-time Edge-Aware
+	Image Processing with the Bilateral Grid", SIGGRAPH 2007.
+
+	1) Splat: every pixel adds its value, and a weight of 1, to the
+	   cell (x/sigma_space, y/sigma_space, guide/sigma_range) of a
+	   coarse 3d grid.
+	2) Blur: the grid is blurred by a [1 4 6 4 1]/16 kernel along each
+	   of its 3 axes.
+	3) Slice: every pixel reads the grid at its own position with a
+	   trilinear interpolation, and divides the values by the weight.
+
+	There is no exp in the loops, the cost per pixel does not depend on
+	the sigmas, and the grid is small: about
+	rows*cols/sigma_space^2 * range/sigma_range cells.
+
+	The guide is the image itself (the mean of the channels for a
+	multichannel image), or a separate single channel image for a
+	joint (cross) bilateral filter.
+
+	The grid is a Matrix<float> with a row per grid row, and each row
+	holds the cells as [range][x][channels + 1]. Every stage is
+	parallel: splatting and the blurs in x and range split the grid
+	rows among the threads, the blur in y and slicing split the rows
+	of their output.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::MatrixWrapper<uchar[3]> frame_wrapper(frame.data, frame.rows, frame.cols);
+		his::bilateral_grid(frame_wrapper, frame_wrapper, 16.0, 20.0, 0);
+
+		// joint bilateral, smoothing a depth map along the edges of the color image
+		his::bilateral_grid(depth_wrapper, gray_wrapper, depth_wrapper, 8.0, 10.0, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols*N/threads + cells*N/threads)
+	Space complexity: 2 grids of cells*(N+1) floats
+*/
+
+#ifndef HIS_IMAGEPROCESSING_BILATERALGRID_HPP
+#define HIS_IMAGEPROCESSING_BILATERALGRID_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "Matrix.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Blur every line of `length` cells along an axis of the grid rows
+	[y0, y1): the cells are `stride` floats apart, and the lines are
+	`length*stride` floats apart. Cells outside of the grid are empty.
+*/
+inline void bilateral_grid_blur_rows(const Matrix<float> &src, Matrix<float> &dst,
+	int length, int stride, int y0, int y1)
+{
+	static const float k[5] = { 1 / 16.f, 4 / 16.f, 6 / 16.f, 4 / 16.f, 1 / 16.f };
+	const int width = src.cols(), line = length * stride;
+
+	for (int y = y0; y < y1; ++y)
+	{
+		const float *s = src[y];
+		float *d = dst[y];
+		for (int start = 0; start < width; start += line)
+		{
+			for (int a = 0; a < length; ++a)
+			{
+				float *out = d + start + a * stride;
+				std::fill(out, out + stride, 0.f);
+				for (int t = std::max(-2, -a); t <= std::min(2, length - 1 - a); ++t)
+				{
+					const float w = k[t + 2];
+					const float *in = s + start + (a + t) * stride;
+					for (int j = 0; j < stride; ++j)
+						out[j] += w * in[j];
+				}
+			}
+		}
+	}
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> input:
+		The input image, of any scalar type, or an array of them for
+		multiple channels.
+	const MatrixWrapper<Guide> guide:
+		The single channel image whose edges are preserved, with the
+		size of the input.
+	MatrixWrapper<Dst> output:
+		The output image, with the same size and number of channels.
+		Can be the input itself. Integer outputs are rounded and
+		saturated, see Convert.hpp.
+	double sigma_space: The spatial extent, in pixels, at least 1.
+	double sigma_range: The range extent, in units of the guide.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Guide, class Dst>
+void bilateral_grid(const MatrixWrapper<Src> input, const MatrixWrapper<Guide> guide,
+	MatrixWrapper<Dst> output, double sigma_space, double sigma_range, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	static_assert(std::is_arithmetic<Guide>::value, "the guide must have a single channel");
+	static_assert(sizeof(Src) / sizeof(SrcScalar) == sizeof(Dst) / sizeof(DstScalar),
+		"input and output must have the same number of channels");
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+	const int cell = channels + 1;
+
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	assert(input.rows() == guide.rows() && input.cols() == guide.cols());
+	assert(sigma_space >= 1 && sigma_range > 0);
+
+	const int rows = input.rows(), cols = input.cols();
+	if (rows == 0 || cols == 0)
+		return;
+
+	// range of the guide
+	std::vector<float> low(thread_count(threads, rows)), high(low.size());
+	parallel_chunks(0, rows, int(low.size()), [&](int chunk, int y0, int y1)
+	{
+		float lo = float(guide[y0][0]), hi = lo;
+		for (int y = y0; y < y1; ++y)
+			for (int x = 0; x < cols; ++x)
+			{
+				lo = std::min(lo, float(guide[y][x]));
+				hi = std::max(hi, float(guide[y][x]));
+			}
+		low[chunk] = lo, high[chunk] = hi;
+	});
+	const float lowest = *std::min_element(low.begin(), low.end());
+	const float highest = *std::max_element(high.begin(), high.end());
+
+	// 2 empty cells of margin for the blur, 1 more for the interpolation
+	const int pad = 2;
+	const float space = float(1 / sigma_space), range = float(1 / sigma_range);
+	const int grid_rows = int((rows - 1) * space) + 2 * pad + 2;
+	const int grid_cols = int((cols - 1) * space) + 2 * pad + 2;
+	const int depth = int((highest - lowest) * range) + 2 * pad + 2;
+	const int plane = grid_cols * cell;
+
+	Matrix<float> grid(grid_rows, depth * plane), blurred(grid_rows, depth * plane);
+
+	// splat to the nearest cell, the threads own whole grid rows
+	parallel_for(0, grid_rows, threads, [&](int g0, int g1)
+	{
+		for (int gy = g0; gy < g1; ++gy)
+			std::fill(grid[gy], grid[gy] + depth * plane, 0.f);
+
+		for (int y = 0; y < rows; ++y)
+		{
+			int gy = int(y * space + 0.5f) + pad;
+			if (gy < g0 || gy >= g1)
+				continue;
+
+			const SrcScalar *src = reinterpret_cast<const SrcScalar *>(input[y]);
+			float *row = grid[gy];
+			for (int x = 0; x < cols; ++x)
+			{
+				int gx = int(x * space + 0.5f) + pad;
+				int gz = int((float(guide[y][x]) - lowest) * range + 0.5f) + pad;
+				float *c = row + gz * plane + gx * cell;
+				for (int i = 0; i < channels; ++i)
+					c[i] += float(src[x * channels + i]);
+				c[channels] += 1;
+			}
+		}
+	});
+
+	// blur along x, then range, then y
+	parallel_for(0, grid_rows, threads, [&](int g0, int g1)
+	{
+		bilateral_grid_blur_rows(grid, blurred, grid_cols, cell, g0, g1);
+		bilateral_grid_blur_rows(blurred, grid, depth, plane, g0, g1);
+	});
+	parallel_for(0, grid_rows, threads, [&](int g0, int g1)
+	{
+		static const float k[5] = { 1 / 16.f, 4 / 16.f, 6 / 16.f, 4 / 16.f, 1 / 16.f };
+		const int width = depth * plane;
+		for (int gy = g0; gy < g1; ++gy)
+		{
+			float *d = blurred[gy];
+			std::fill(d, d + width, 0.f);
+			for (int t = std::max(-2, -gy); t <= std::min(2, grid_rows - 1 - gy); ++t)
+			{
+				const float w = k[t + 2];
+				const float *s = grid[gy + t];
+				for (int i = 0; i < width; ++i)
+					d[i] += w * s[i];
+			}
+		}
+	});
+
+	// slice with a trilinear interpolation
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		std::vector<float> values(cell);
+		for (int y = y0; y < y1; ++y)
+		{
+			const SrcScalar *src = reinterpret_cast<const SrcScalar *>(input[y]);
+			DstScalar *dst = reinterpret_cast<DstScalar *>(output[y]);
+
+			float fy = y * space + pad;
+			int gy = int(fy);
+			float wy = fy - gy;
+
+			for (int x = 0; x < cols; ++x)
+			{
+				float fx = x * space + pad, fz = (float(guide[y][x]) - lowest) * range + pad;
+				int gx = int(fx), gz = int(fz);
+				float wx = fx - gx, wz = fz - gz;
+
+				std::fill(values.begin(), values.end(), 0.f);
+				for (int dy = 0; dy < 2; ++dy)
+					for (int dz = 0; dz < 2; ++dz)
+					{
+						const float *c = blurred[gy + dy] + (gz + dz) * plane + gx * cell;
+						float w = (dy ? wy : 1 - wy) * (dz ? wz : 1 - wz);
+						for (int i = 0; i < cell; ++i)
+							values[i] += w * ((1 - wx) * c[i] + wx * c[cell + i]);
+					}
+
+				// the pixel itself is in the neighborhood, so the weight is
+				// positive unless it is lost in rounding
+				if (values[channels] > 0)
+				{
+					for (int i = 0; i < channels; ++i)
+						dst[x * channels + i] = saturate_cast<DstScalar>(values[i] / values[channels]);
+				}
+				else
+				{
+					for (int i = 0; i < channels; ++i)
+						dst[x * channels + i] = saturate_cast<DstScalar>(src[x * channels + i]);
+				}
+			}
+		}
+	});
+}
+
+
+/*
+	The bilateral filter of an image guided by itself, the mean of the
+	channels for multiple channels. See above.
+*/
+template<class Src, class Dst>
+void bilateral_grid(const MatrixWrapper<Src> input, MatrixWrapper<Dst> output,
+	double sigma_space, double sigma_range, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+	const int rows = input.rows(), cols = input.cols();
+
+	Matrix<float> guide(rows, cols);
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			const SrcScalar *src = reinterpret_cast<const SrcScalar *>(input[y]);
+			for (int x = 0; x < cols; ++x)
+			{
+				float sum = 0;
+				for (int i = 0; i < channels; ++i)
+					sum += float(src[x * channels + i]);
+				guide[y][x] = sum / channels;
+			}
+		}
+	});
+
+	bilateral_grid(input, MatrixWrapper<float>(guide), output, sigma_space, sigma_range, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_BILATERALGRID_HPP
@@ -0,0 +1,160 @@
+/*	================================================================
+	Assign dense ids 0, 1, ..., M-1 to the selected pixels of a
+	matrix, in row-major order, e.g. to number the unknowns of a
+	linear system defined on an image region.
+
+	The result is an id map (-1 for the pixels not selected), and the
+	inverse list from ids to pixel positions.
+
+	Usage:
+
+		his::Matrix<int> id_map(mask.rows(), mask.cols());
+		std::vector<his::Idx> positions;
+		int unknowns = his::compact_id_map(mask, id_map, positions,
+			[](uchar m) { return m != 0; });
+
+		// id_map(positions[id]) == id
+
+	The selection can also be a RunLengthMask, or depend on the
+	position through an IdxMap:
+
+		his::compact_id_map(his::IdxMap(mask), id_map, positions,
+			[&](his::Idx idx) { return near_the_border(idx); });
+
+	In parallel mode, the selected pixels of every row are counted
+	concurrently, an exclusive scan of the counts gives the first id
+	of every row, then the rows are numbered concurrently. The ids
+	do not depend on the number of threads.
+*/
+
+#ifndef HIS_IMAGEPROCESSING_COMPACTIDMAP_HPP
+#define HIS_IMAGEPROCESSING_COMPACTIDMAP_HPP
+
+#include <cassert>
+#include <vector>
+
+#include "IdxMap.hpp"
+#include "MatrixWrapper.hpp"
+#include "RunLengthMask.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Inputs:
+	Mat mat: Any FOR_EACH_ABLE matrix, including IdxMap.
+	MatrixWrapper<int> id_map:
+		The output, the id of each selected pixel and -1 elsewhere.
+		Same size as mat.
+	std::vector<Idx> &positions:
+		The output, positions[id] is the pixel numbered id.
+	SelectFunc select:
+		A functor taking an element of mat, returning true if the
+		pixel gets an id.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+
+	Output:
+	The number of selected pixels.
+*/
+template<class Mat, class SelectFunc>
+int compact_id_map(Mat mat, MatrixWrapper<int> id_map, std::vector<Idx> &positions,
+	SelectFunc select, int threads = 1)
+{
+    assert(Mat::FOR_EACH_ABLE == Mat::FOR_EACH_ABLE);
+	assert(mat.rows() == id_map.rows() && mat.cols() == id_map.cols());
+
+	// mark the selection in the id map, and count per row
+	std::vector<int> row_start(id_map.rows() + 1, 0);
+	parallel_for(0, id_map.rows(), threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			auto p = mat[y];
+			int *ids = id_map[y];
+			int count = 0;
+			for (int x = 0; x < id_map.cols(); ++x)
+			{
+				bool selected = select(*p);
+				ids[x] = selected ? 0 : -1;
+				count += selected;
+				p += 1;
+			}
+			row_start[y + 1] = count;
+		}
+	});
+
+	// exclusive scan
+	for (int y = 0; y < id_map.rows(); ++y)
+		row_start[y + 1] += row_start[y];
+
+	// number the marked pixels, from the first id of each row
+	positions.resize(row_start[id_map.rows()]);
+	parallel_for(0, id_map.rows(), threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			int *ids = id_map[y];
+			int id = row_start[y];
+			for (int x = 0; x < id_map.cols(); ++x)
+			{
+				if (ids[x] >= 0)
+				{
+					positions[id] = Idx(x, y);
+					ids[x] = id++;
+				}
+			}
+		}
+	});
+	return row_start[id_map.rows()];
+}
+
+
+/*
+	The same, selecting the pixels inside a RunLengthMask.
+*/
+inline int compact_id_map(const RunLengthMask &mask, MatrixWrapper<int> id_map,
+	std::vector<Idx> &positions, int threads = 1)
+{
+	assert(mask.rows() == id_map.rows() && mask.cols() == id_map.cols());
+
+	// the counts come from the runs
+	std::vector<int> row_start(id_map.rows() + 1, 0);
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		int count = 0;
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+			count += run->x1 - run->x0;
+		row_start[y + 1] = row_start[y] + count;
+	}
+
+	positions.resize(row_start[id_map.rows()]);
+	parallel_for(0, id_map.rows(), threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			int *ids = id_map[y];
+			int id = row_start[y];
+			int x = 0;
+			for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+			{
+				for (; x < run->x0; ++x)
+					ids[x] = -1;
+				for (; x < run->x1; ++x)
+				{
+					positions[id] = Idx(x, y);
+					ids[x] = id++;
+				}
+			}
+			for (; x < id_map.cols(); ++x)
+				ids[x] = -1;
+		}
+	});
+	return row_start[id_map.rows()];
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_COMPACTIDMAP_HPP
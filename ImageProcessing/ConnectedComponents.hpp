@@ -0,0 +1,313 @@
+/*	================================================================
+	Connected component labeling over a matrix.
+
+	Two neighboring pixels p and q belong to the same component if
+	same(p, q) holds, for a user defined predicate `same`, e.g. equal
+	values, or a difference under a threshold. Neighbors are the 4
+	pixels sharing an edge, or the 8 pixels sharing a corner.
+
+	The labeling is done in two passes:
+	1) A raster scan merges every pixel with its already visited
+	   neighbors into a union-find set.
+	2) After the sets are reduced to dense ids, a second scan writes
+	   the labels and accumulates area, bounding box and centroid of
+	   every component.
+
+	Labels are 0, 1, ..., M-1, in the row-major order of the first
+	pixel of each component.
+
+	In parallel mode, each thread scans a strip of rows into a
+	lock-free union-find set, the rows at the strip borders are
+	merged afterwards, and the second pass runs on the same strips,
+	each with the statistics of the components it touches only.
+	Labels are identical to the ones of the single threaded mode.
+
+	================================================================
+
+	Usage:
+
+		his::Matrix<int> labels(gray.rows(), gray.cols());
+		auto components = his::connected_components(gray, labels, 8,
+			[](uchar a, uchar b) { return std::abs(a - b) < 8; });
+
+		for (auto &c : components)
+			printf("area %d at (%f, %f)\n", c.area, c.x, c.y);
+
+	================================================================
+
+	Time complexity: O(rows*cols), near linear union-find aside.
+	Space complexity: 8 bytes per pixel for the union-find set, O(M)
+	for the statistics, and O(cols) more per thread.
+*/
+
+#ifndef HIS_IMAGEPROCESSING_CONNECTEDCOMPONENTS_HPP
+#define HIS_IMAGEPROCESSING_CONNECTEDCOMPONENTS_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "MatrixWrapper.hpp"
+#include "../DataStructure/ConcurrentUFSet.hpp"
+#include "../DataStructure/UFSet.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Statistics of a connected component.
+	The bounding box is inclusive: [left, right] x [top, bottom].
+	(x, y) is the centroid.
+*/
+struct Component
+{
+	int area;
+	int left, top, right, bottom;
+	double x, y;
+};
+
+
+// merge the pixels of row y with their neighbors on the left, and with
+// their neighbors in row y-1 if with_top is set
+template<class Mat, class SameFunc, class Sets>
+void merge_component_row(const Mat &input, SameFunc &same, int connectivity,
+	Sets &sets, int y, bool with_top)
+{
+	auto row = input[y];
+	size_t base = size_t(y) * input.cols();
+	for (int x = 1; x < input.cols(); ++x)
+		if (same(row[x - 1], row[x]))
+			sets.Merge(base + x - 1, base + x);
+
+	if (!with_top)
+		return;
+
+	auto up = input[y - 1];
+	size_t up_base = base - input.cols();
+	for (int x = 0; x < input.cols(); ++x)
+	{
+		if (same(up[x], row[x]))
+			sets.Merge(up_base + x, base + x);
+
+		if (connectivity == 8)
+		{
+			if (x > 0 && same(up[x - 1], row[x]))
+				sets.Merge(up_base + x - 1, base + x);
+			if (x + 1 < input.cols() && same(up[x + 1], row[x]))
+				sets.Merge(up_base + x + 1, base + x);
+		}
+	}
+}
+
+
+// write the labels of rows [y0, y1)
+// Output: the largest label written, -1 for no row
+template<class Sets>
+int write_component_rows(const Sets &sets, MatrixWrapper<int> &labels, int y0, int y1)
+{
+	int largest = -1;
+	for (int y = y0; y < y1; ++y)
+	{
+		int *row = labels[y];
+		size_t base = size_t(y) * labels.cols();
+		for (int x = 0; x < labels.cols(); ++x)
+			largest = std::max(largest, row[x] = sets.Query(base + x));
+	}
+	return largest;
+}
+
+
+// accumulate the statistics of rows [y0, y1) into stats[slot(label)]
+template<class SlotFunc>
+void accumulate_component_rows(const MatrixWrapper<int> &labels, std::vector<Component> &stats,
+	SlotFunc slot, int y0, int y1)
+{
+	int last_label = -1;
+	Component *c = 0;
+	for (int y = y0; y < y1; ++y)
+	{
+		const int *row = labels[y];
+		for (int x = 0; x < labels.cols(); ++x)
+		{
+			// runs of the same label are frequent, look up once per run
+			if (row[x] != last_label)
+				c = &stats[slot(last_label = row[x])];
+
+			if (c->area++ == 0)
+			{
+				c->left = c->right = x, c->top = c->bottom = y;
+			}
+			else
+			{
+				c->left = std::min(c->left, x), c->right = std::max(c->right, x);
+				c->top = std::min(c->top, y), c->bottom = std::max(c->bottom, y);
+			}
+			c->x += x, c->y += y;
+		}
+	}
+}
+
+
+// add the statistics of a part of a component to the ones of the rest
+inline void merge_component(Component &c, const Component &p)
+{
+	if (p.area == 0)
+		return;
+	if (c.area == 0)
+	{
+		c = p;
+		return;
+	}
+	c.area += p.area;
+	c.left = std::min(c.left, p.left), c.right = std::max(c.right, p.right);
+	c.top = std::min(c.top, p.top), c.bottom = std::max(c.bottom, p.bottom);
+	c.x += p.x, c.y += p.y;
+}
+
+
+/*
+	Inputs:
+	const Mat input: The matrix to label.
+	MatrixWrapper<int> labels:
+		The output label of each pixel, with the same size as input.
+	int connectivity: 4 or 8.
+	SameFunc same:
+		A functor taking two neighboring elements of input, returning
+		true if they belong to the same component.
+	int threads:
+		Number of threads (strips), 0 for all cores. See Parallel.hpp.
+
+	Output:
+	The statistics of each component, indexed by label.
+*/
+template<class Mat, class SameFunc>
+std::vector<Component> connected_components(const Mat input, MatrixWrapper<int> labels,
+	int connectivity, SameFunc same, int threads = 1)
+{
+    assert(Mat::FOR_EACH_ABLE == Mat::FOR_EACH_ABLE);
+	assert(input.rows() == labels.rows() && input.cols() == labels.cols());
+	assert(connectivity == 4 || connectivity == 8);
+
+	size_t pixels = size_t(input.rows()) * input.cols();
+	int strips = thread_count(threads, input.rows());
+	std::vector<int> strip_start(strips, 0), strip_largest(strips, -1);
+
+	if (strips == 1)
+	{
+		UFSet sets(pixels);
+		for (int y = 0; y < input.rows(); ++y)
+			merge_component_row(input, same, connectivity, sets, y, y > 0);
+
+		sets.Reduce();
+		strip_largest[0] = write_component_rows(sets, labels, 0, input.rows());
+	}
+	else
+	{
+		ConcurrentUFSet sets(pixels);
+
+		parallel_chunks(0, input.rows(), strips, [&](int strip, int y0, int y1)
+		{
+			strip_start[strip] = y0;
+			for (int y = y0; y < y1; ++y)
+				merge_component_row(input, same, connectivity, sets, y, y > y0);
+		});
+
+		// stitch the strips together, the horizontal merges of the 
+		// border rows are done twice, which is harmless
+		parallel_for(1, strips, strips - 1, [&](int s0, int s1)
+		{
+			for (int strip = s0; strip < s1; ++strip)
+				if (strip_start[strip] > 0)
+					merge_component_row(input, same, connectivity, sets, strip_start[strip], true);
+		});
+
+		sets.Reduce(strips);
+		parallel_chunks(0, input.rows(), strips, [&](int strip, int y0, int y1)
+		{
+			strip_largest[strip] = write_component_rows(sets, labels, y0, y1);
+		});
+	}
+
+	/*
+		Labels follow the row-major order of the first pixels, so the
+		components starting in a strip have the labels [first, end)
+		between the ones of the previous strips and the next ones. A
+		component starting above a strip and reaching into it crosses
+		its first row, so there are at most cols of those per strip.
+		Each strip accumulates into a compact array of its own
+		components, and never holds all the M components.
+	*/
+	std::vector<int> first(strips + 1, 0);
+	for (int strip = 0; strip < strips; ++strip)
+		first[strip + 1] = std::max(first[strip], strip_largest[strip] + 1);
+	const int count = first[strips];
+
+	Component empty = { 0, 0, 0, 0, 0, 0.0, 0.0 };
+	std::vector<Component> components(count, empty);
+	std::vector<std::vector<int>> older(strips);
+	std::vector<std::vector<Component>> older_stats(strips);
+
+	parallel_chunks(0, input.rows(), strips, [&](int strip, int y0, int y1)
+	{
+		if (y0 >= y1)
+			return;
+
+		// components from above, sorted, found in the first row
+		std::vector<int> &old = older[strip];
+		const int *top = labels[y0];
+		for (int x = 0; x < labels.cols(); ++x)
+			if (top[x] < first[strip])
+				old.push_back(top[x]);
+		std::sort(old.begin(), old.end());
+		old.erase(std::unique(old.begin(), old.end()), old.end());
+
+		// the own components are written to their final place, the
+		// other strips touch them only through older_stats
+		std::vector<Component> stats(old.size() + first[strip + 1] - first[strip], empty);
+		int own = int(old.size()) - first[strip];
+		accumulate_component_rows(labels, stats, [&](int label) -> int
+		{
+			if (label >= first[strip])
+				return own + label;
+			return int(std::lower_bound(old.begin(), old.end(), label) - old.begin());
+		}, y0, y1);
+
+		std::copy(stats.begin() + old.size(), stats.end(), components.begin() + first[strip]);
+		older_stats[strip].assign(stats.begin(), stats.begin() + old.size());
+	});
+
+	// add the parts of the components from above, at most cols per strip
+	for (int strip = 1; strip < strips; ++strip)
+		for (size_t i = 0; i < older[strip].size(); ++i)
+			merge_component(components[older[strip][i]], older_stats[strip][i]);
+
+	// turn coordinate sums into centroids
+	parallel_for(0, count, threads, [&](int l0, int l1)
+	{
+		for (int label = l0; label < l1; ++label)
+		{
+			Component &c = components[label];
+			c.x /= c.area, c.y /= c.area;
+		}
+	});
+	return components;
+}
+
+
+/*
+	Label the components of equal values, for scalar element types.
+*/
+template<class Mat>
+std::vector<Component> connected_components(const Mat input, MatrixWrapper<int> labels,
+	int connectivity = 4, int threads = 1)
+{
+	typedef decltype(*input[0]) Element;
+	return connected_components(input, labels, connectivity,
+		[](Element a, Element b) { return a == b; }, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_CONNECTEDCOMPONENTS_HPP
@@ -0,0 +1,175 @@
+/*	================================================================
+	Type conversion between matrices of unsigned char, short, int,
+	float, double, etc., with rounding and saturation:
+
+		dst = saturate_cast<Dst>(src * scale + offset)
+
+	Floating point values are rounded to the nearest integer (halves
+	away from zero), then clamped to the range of the destination
+	type, NaN becomes its lowest value. Multichannel T[N] matrices are
+	converted channel by channel, both sides must have the same N.
+
+	A row is converted as one flat loop over cols*N scalars, with
+	branch-free clamping, so the compiler can vectorize it. Scale and
+	offset are applied in the same loop, in float when both types fit
+	in a float, in double otherwise. Without scale and offset, matrices
+	of the same type are simply copied.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		// normalize a float image in [-1, 1] to 8-bit, using all cores
+		his::convert(his::MatrixWrapper<float>(depth.data, depth.rows, depth.cols),
+			his::MatrixWrapper<uchar>(view.data, view.rows, view.cols),
+			127.5, 127.5, 0);
+
+		// or a single value
+		uchar c = his::saturate_cast<uchar>(-3.7);	// 0
+*/
+
+#ifndef HIS_IMAGEPROCESSING_CONVERT_HPP
+#define HIS_IMAGEPROCESSING_CONVERT_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "MatrixWrapper.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	To a floating point type: a plain cast.
+*/
+template<class Dst, class Src>
+typename std::enable_if<std::is_floating_point<Dst>::value, Dst>::type
+saturate_cast(Src v)
+{
+	return Dst(v);
+}
+
+
+/*
+	The largest value of the floating point type Work which is not above
+	the maximum of the integer type Dst. The maximum of a 64-bit integer
+	is not a double, it would round up to 2^63 (2^64), out of range of
+	the final cast.
+*/
+template<class Dst, class Work>
+Work saturate_high()
+{
+	Work hi = Work(std::numeric_limits<Dst>::max());
+	if (std::numeric_limits<Dst>::digits > std::numeric_limits<Work>::digits)
+		hi = std::nextafter(hi, Work(0));
+	return hi;
+}
+
+
+/*
+	From a floating point type to an integer type: clamp, then round.
+	32-bit and larger integers are clamped in double. The fraction of
+	the clamped value is exact, so halves are found without the error
+	of adding 0.5 (0.49999997f + 0.5f is 1 in float). Values above the
+	largest double under a 64-bit maximum saturate to the maximum
+	itself.
+*/
+template<class Dst, class Src>
+typename std::enable_if<std::is_integral<Dst>::value && std::is_floating_point<Src>::value, Dst>::type
+saturate_cast(Src v)
+{
+	typedef typename std::conditional<(sizeof(Dst) < 4), Src, double>::type Work;
+	const Work lo = Work(std::numeric_limits<Dst>::min());
+	const Work hi = saturate_high<Dst, Work>();
+
+	Work w = Work(v);
+	const bool above = w > hi;
+	w = w >= lo ? (above ? hi : w) : lo;
+	Work r = std::trunc(w), f = w - r;
+	r += Work(f >= Work(0.5)) - Work(f <= Work(-0.5));
+	return above ? std::numeric_limits<Dst>::max() : Dst(r);
+}
+
+
+/*
+	Between integer types: clamp.
+*/
+template<class Dst, class Src>
+typename std::enable_if<std::is_integral<Dst>::value && std::is_integral<Src>::value, Dst>::type
+saturate_cast(Src v)
+{
+	typedef typename std::conditional<(sizeof(Src) < 4 && sizeof(Dst) < 4), int, long long>::type Work;
+	const Work lo = Work(std::numeric_limits<Dst>::min());
+	const Work hi = Work(std::numeric_limits<Dst>::max());
+
+	Work w = Work(v);
+	return Dst(w < lo ? lo : (w > hi ? hi : w));
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> src: The source.
+	MatrixWrapper<Dst> dst:
+		The destination, with the same size and number of channels.
+	double scale, double offset:
+		Applied to the source values before rounding and saturation.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void convert(const MatrixWrapper<Src> src, MatrixWrapper<Dst> dst,
+	double scale = 1, double offset = 0, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	static_assert(sizeof(Src) / sizeof(SrcScalar) == sizeof(Dst) / sizeof(DstScalar),
+		"src and dst must have the same number of channels");
+
+	// float is enough for 8 and 16-bit integers and float itself
+	const bool src_float = sizeof(SrcScalar) <= 2 || std::is_same<SrcScalar, float>::value;
+	const bool dst_float = sizeof(DstScalar) <= 2 || std::is_same<DstScalar, float>::value;
+	typedef typename std::conditional<src_float && dst_float, float, double>::type Work;
+
+	assert(src.rows() == dst.rows() && src.cols() == dst.cols());
+
+	const int count = src.cols() * int(sizeof(Src) / sizeof(SrcScalar));
+	const bool scaled = scale != 1 || offset != 0;
+	const Work work_scale = Work(scale), work_offset = Work(offset);
+
+	parallel_for(0, src.rows(), threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			const SrcScalar *s = reinterpret_cast<const SrcScalar *>(src[y]);
+			DstScalar *d = reinterpret_cast<DstScalar *>(dst[y]);
+
+			if (scaled)
+			{
+				for (int i = 0; i < count; ++i)
+					d[i] = saturate_cast<DstScalar>(Work(s[i]) * work_scale + work_offset);
+			}
+			else if (std::is_same<SrcScalar, DstScalar>::value)
+			{
+				if (static_cast<const void *>(s) != static_cast<void *>(d))
+					memcpy(d, s, count * sizeof(DstScalar));
+			}
+			else
+			{
+				for (int i = 0; i < count; ++i)
+					d[i] = saturate_cast<DstScalar>(s[i]);
+			}
+		}
+	});
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_CONVERT_HPP
@@ -0,0 +1,411 @@
+/*	================================================================
+	2d convolution of float images with large dense kernels, choosing
+	between three methods:
+
+	1) direct: every tap is a multiply-add over a whole row,
+	   O(krows*kcols) per pixel.
+	2) separable: when the kernel is the outer product of a column and
+	   a row, a horizontal then a vertical pass, O(krows+kcols) per
+	   pixel.
+	3) FFT: the image is cut into tiles, each tile is multiplied with
+	   the spectrum of the kernel in the frequency domain, O(log(tile))
+	   per pixel.
+
+	The automatic mode compares the estimated cost per pixel of each
+	method. The FFT tiles are square powers of 2; a tile of size T
+	yields T-k+1 output rows and columns (overlap-save), so the memory
+	stays bounded by a few tiles per thread whatever the image size.
+	Two tiles are transformed at once, as the real and imaginary parts
+	of the same complex tile.
+
+	ConvolutionKernel keeps the spectra of the kernel computed for each
+	tile size, so applying the same kernel to many images only
+	transforms the image tiles.
+
+	The result is the convolution (the kernel is flipped):
+		output(y, x) = sum kernel(ky, kx) * input(y + ry - ky, x + rx - kx)
+	with ry = krows/2 and rx = kcols/2. filter() in Filter.hpp and
+	filter_bank() in FilterBank.hpp compute the correlation instead,
+	input(y - ry + ky, x - rx + kx): the results are the same for
+	symmetric kernels, and otherwise the same once the kernel is
+	rotated by 180 degrees. The kernel is not normalized. Pixels
+	outside of the image are replicated from the border, in every
+	method.
+
+	================================================================
+
+	Usage:
+
+		his::ConvolutionKernel psf(psf_wrapper);	// 65 x 65
+
+		for (auto &frame : frames)
+			his::convolve(frame, blurred, psf, 0);
+
+		// or force a method
+		his::convolve(frame, blurred, psf, his::CONVOLUTION_DIRECT);
+*/
+
+#ifndef HIS_IMAGEPROCESSING_CONVOLUTION_HPP
+#define HIS_IMAGEPROCESSING_CONVOLUTION_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "../Miscellaneous/FFT.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+enum ConvolutionMethod
+{
+	CONVOLUTION_AUTO,
+	CONVOLUTION_DIRECT,
+	CONVOLUTION_SEPARABLE,
+	CONVOLUTION_FFT
+};
+
+
+/*
+	A kernel with odd sizes, its separable factors if any, and the
+	cache of its spectra.
+*/
+class ConvolutionKernel
+{
+public:
+	typedef std::complex<float> Complex;
+
+	/*
+		Input:
+			const MatrixWrapper<float> kernel:
+				The kernel, with odd sizes. It is copied.
+	*/
+	explicit ConvolutionKernel(const MatrixWrapper<float> kernel)
+		: m_kernel(kernel.rows(), kernel.cols()), m_separable(false)
+	{
+		assert(kernel.rows() % 2 == 1 && kernel.cols() % 2 == 1);
+		for (int y = 0; y < rows(); ++y)
+			std::copy(kernel[y], kernel[y] + cols(), m_kernel[y]);
+
+		// rank 1 test around the largest weight
+		int py = 0, px = 0;
+		float largest = 0;
+		for (int y = 0; y < rows(); ++y)
+			for (int x = 0; x < cols(); ++x)
+				if (std::fabs(m_kernel[y][x]) > largest)
+					largest = std::fabs(m_kernel[y][x]), py = y, px = x;
+		if (largest == 0)
+			return;
+
+		m_column.resize(rows());
+		m_row.resize(cols());
+		for (int y = 0; y < rows(); ++y)
+			m_column[y] = m_kernel[y][px];
+		for (int x = 0; x < cols(); ++x)
+			m_row[x] = m_kernel[py][x] / m_kernel[py][px];
+
+		m_separable = true;
+		for (int y = 0; y < rows() && m_separable; ++y)
+			for (int x = 0; x < cols() && m_separable; ++x)
+				if (std::fabs(m_kernel[y][x] - m_column[y] * m_row[x]) > 1e-5f * largest)
+					m_separable = false;
+	}
+
+	int rows() const { return m_kernel.rows(); }
+	int cols() const { return m_kernel.cols(); }
+	const MatrixWrapper<float> &weights() const { return m_kernel; }
+
+	bool separable() const { return m_separable; }
+	const std::vector<float> &column() const { return m_column; }
+	const std::vector<float> &row() const { return m_row; }
+
+	/*
+		Output:
+			The spectrum of the kernel in a tile of the given size,
+			divided by the number of elements, so that an inverse
+			transform gives the convolution directly. Computed on the
+			first call for each size, thread safe.
+	*/
+	const std::vector<Complex> &spectrum(int tile) const
+	{
+		std::lock_guard<std::mutex> lock(*m_mutex);
+		std::vector<Complex> &spectrum = (*m_spectra)[tile];
+		if (spectrum.empty())
+		{
+			assert(tile >= rows() && tile >= cols());
+			spectrum.assign(tile * tile, Complex(0, 0));
+			float scale = 1.f / (float(tile) * tile);
+			for (int y = 0; y < rows(); ++y)
+				for (int x = 0; x < cols(); ++x)
+					spectrum[y * tile + x] = Complex(m_kernel[y][x] * scale, 0);
+			FFT2D(tile).forward(&spectrum[0]);
+		}
+		return spectrum;
+	}
+
+private:
+	Matrix<float> m_kernel;
+	bool m_separable;
+	std::vector<float> m_column, m_row;
+
+	// shared by the copies, which have the same kernel
+	std::shared_ptr<std::map<int, std::vector<Complex>>> m_spectra
+		= std::make_shared<std::map<int, std::vector<Complex>>>();
+	std::shared_ptr<std::mutex> m_mutex = std::make_shared<std::mutex>();
+};
+
+
+/*
+	The estimated cost per pixel of the FFT method with a given tile,
+	in multiply-adds: 2 transforms of 5/2*log2(n) per element, and the
+	complex product, for two tiles of (T-k+1)^2 pixels.
+*/
+inline double fft_convolution_cost(int tile, int krows, int kcols)
+{
+	double elements = double(tile) * tile;
+	double transforms = elements * (5 * std::log2(elements) + 4);
+	return transforms / (2.0 * (tile - krows + 1) * (tile - kcols + 1));
+}
+
+
+// the tile size of the cheapest FFT method for an image
+inline int fft_convolution_tile(int rows, int cols, int krows, int kcols)
+{
+	int k = std::max(krows, kcols);
+	int tile = 1;
+	while (tile < 2 * k)
+		tile *= 2;
+
+	// larger tiles waste less overlap, as long as the image fills them
+	int best = tile;
+	for (int t = tile * 2; t <= 1024 && t - k + 1 <= 2 * std::max(rows, cols); t *= 2)
+		if (fft_convolution_cost(t, krows, kcols) < fft_convolution_cost(best, krows, kcols))
+			best = t;
+	return best;
+}
+
+
+// direct: a multiply-add per tap over padded rows
+inline void convolve_direct(const MatrixWrapper<float> &input, MatrixWrapper<float> &output,
+	const ConvolutionKernel &kernel, int threads)
+{
+	const MatrixWrapper<float> &weights = kernel.weights();
+	const int ry = kernel.rows() / 2, rx = kernel.cols() / 2;
+	const int rows = input.rows(), cols = input.cols();
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		std::vector<float> padded(cols + 2 * rx), acc(cols);
+		for (int y = y0; y < y1; ++y)
+		{
+			std::fill(acc.begin(), acc.end(), 0.f);
+			for (int ky = 0; ky < kernel.rows(); ++ky)
+			{
+				const float *src = input[std::min(std::max(y + ry - ky, 0), rows - 1)];
+				for (int x = 0; x < cols + 2 * rx; ++x)
+					padded[x] = src[std::min(std::max(x - rx, 0), cols - 1)];
+
+				for (int kx = 0; kx < kernel.cols(); ++kx)
+				{
+					const float w = weights[ky][kx];
+					if (w == 0)
+						continue;
+					const float *p = &padded[2 * rx - kx];
+					for (int x = 0; x < cols; ++x)
+						acc[x] += w * p[x];
+				}
+			}
+			std::copy(acc.begin(), acc.end(), output[y]);
+		}
+	});
+}
+
+
+// separable: horizontal pass by the row factor, vertical by the column
+inline void convolve_separable(const MatrixWrapper<float> &input, MatrixWrapper<float> &output,
+	const ConvolutionKernel &kernel, int threads)
+{
+	const std::vector<float> &row = kernel.row(), &column = kernel.column();
+	const int ry = kernel.rows() / 2, rx = kernel.cols() / 2;
+	const int rows = input.rows(), cols = input.cols();
+	Matrix<float> buffer(rows, cols);
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		std::vector<float> padded(cols + 2 * rx);
+		for (int y = y0; y < y1; ++y)
+		{
+			const float *src = input[y];
+			for (int x = 0; x < cols + 2 * rx; ++x)
+				padded[x] = src[std::min(std::max(x - rx, 0), cols - 1)];
+
+			float *dst = buffer[y];
+			std::fill(dst, dst + cols, 0.f);
+			for (int kx = 0; kx < kernel.cols(); ++kx)
+			{
+				const float w = row[kx];
+				const float *p = &padded[2 * rx - kx];
+				for (int x = 0; x < cols; ++x)
+					dst[x] += w * p[x];
+			}
+		}
+	});
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		std::vector<float> acc(cols);
+		for (int y = y0; y < y1; ++y)
+		{
+			std::fill(acc.begin(), acc.end(), 0.f);
+			for (int ky = 0; ky < kernel.rows(); ++ky)
+			{
+				const float w = column[ky];
+				const float *p = buffer[std::min(std::max(y + ry - ky, 0), rows - 1)];
+				for (int x = 0; x < cols; ++x)
+					acc[x] += w * p[x];
+			}
+			std::copy(acc.begin(), acc.end(), output[y]);
+		}
+	});
+}
+
+
+// FFT: overlap-save over square tiles, two real tiles per complex one
+inline void convolve_fft(const MatrixWrapper<float> &input, MatrixWrapper<float> &output,
+	const ConvolutionKernel &kernel, int tile, int threads)
+{
+	typedef std::complex<float> Complex;
+
+	const int rows = input.rows(), cols = input.cols();
+	const int krows = kernel.rows(), kcols = kernel.cols();
+	const int ry = krows / 2, rx = kcols / 2;
+
+	// each tile yields block_rows x block_cols output pixels
+	const int block_rows = tile - krows + 1, block_cols = tile - kcols + 1;
+	const int tiles_y = (rows + block_rows - 1) / block_rows;
+	const int tiles_x = (cols + block_cols - 1) / block_cols;
+	const int pairs_x = (tiles_x + 1) / 2;
+
+	const std::vector<Complex> &spectrum = kernel.spectrum(tile);
+	const FFT2D fft(tile);
+
+	parallel_for(0, tiles_y * pairs_x, threads, [&](int p0, int p1)
+	{
+		std::vector<Complex> data(tile * tile);
+		for (int p = p0; p < p1; ++p)
+		{
+			const int oy = p / pairs_x * block_rows;
+			const int ox[2] = { p % pairs_x * 2 * block_cols, (p % pairs_x * 2 + 1) * block_cols };
+			const bool second = ox[1] < cols;
+
+			// the input window of an output block starts ry rows and rx
+			// columns before it, the first krows-1 and kcols-1 outputs of
+			// the circular convolution are wrapped around and dropped
+			for (int y = 0; y < tile; ++y)
+			{
+				const float *src = input[std::min(std::max(oy - ry + y, 0), rows - 1)];
+				Complex *d = &data[y * tile];
+				for (int x = 0; x < tile; ++x)
+				{
+					float re = src[std::min(std::max(ox[0] - rx + x, 0), cols - 1)];
+					float im = second ? src[std::min(std::max(ox[1] - rx + x, 0), cols - 1)] : 0.f;
+					d[x] = Complex(re, im);
+				}
+			}
+
+			fft.forward(&data[0]);
+			for (int i = 0; i < tile * tile; ++i)
+				data[i] *= spectrum[i];
+			fft.inverse(&data[0]);
+
+			// the valid part of the circular convolution
+			for (int y = 0; y < block_rows && oy + y < rows; ++y)
+			{
+				const Complex *d = &data[(y + krows - 1) * tile + kcols - 1];
+				float *dst = output[oy + y];
+				for (int x = 0; x < block_cols && ox[0] + x < cols; ++x)
+					dst[ox[0] + x] = d[x].real();
+				if (second)
+					for (int x = 0; x < block_cols && ox[1] + x < cols; ++x)
+						dst[ox[1] + x] = d[x].imag();
+			}
+		}
+	});
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<float> input: The input image.
+	MatrixWrapper<float> output:
+		The output image, with the same size. Must not be the input.
+	const ConvolutionKernel &kernel: The kernel.
+	ConvolutionMethod method:
+		CONVOLUTION_AUTO picks the cheapest method, the others force one.
+		CONVOLUTION_SEPARABLE requires a separable kernel.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+inline void convolve(const MatrixWrapper<float> input, MatrixWrapper<float> output,
+	const ConvolutionKernel &kernel, ConvolutionMethod method, int threads = 1)
+{
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	if (input.rows() == 0 || input.cols() == 0)
+		return;
+	assert(input[0] != output[0]);
+
+	int tile = fft_convolution_tile(input.rows(), input.cols(), kernel.rows(), kernel.cols());
+	if (method == CONVOLUTION_AUTO)
+	{
+		double direct = double(kernel.rows()) * kernel.cols();
+		double separable = kernel.separable() ? kernel.rows() + kernel.cols() : direct;
+		double fft = fft_convolution_cost(tile, kernel.rows(), kernel.cols());
+		if (separable < direct)
+			method = separable <= fft ? CONVOLUTION_SEPARABLE : CONVOLUTION_FFT;
+		else
+			method = direct <= fft ? CONVOLUTION_DIRECT : CONVOLUTION_FFT;
+	}
+
+	switch (method)
+	{
+	case CONVOLUTION_SEPARABLE:
+		assert(kernel.separable());
+		convolve_separable(input, output, kernel, threads);
+		break;
+	case CONVOLUTION_FFT:
+		convolve_fft(input, output, kernel, tile, threads);
+		break;
+	default:
+		convolve_direct(input, output, kernel, threads);
+		break;
+	}
+}
+
+
+inline void convolve(const MatrixWrapper<float> input, MatrixWrapper<float> output,
+	const ConvolutionKernel &kernel, int threads = 1)
+{
+	convolve(input, output, kernel, CONVOLUTION_AUTO, threads);
+}
+
+
+/*
+	The same with a kernel used once, its spectrum is not kept.
+*/
+inline void convolve(const MatrixWrapper<float> input, MatrixWrapper<float> output,
+	const MatrixWrapper<float> kernel, int threads = 1)
+{
+	convolve(input, output, ConvolutionKernel(kernel), CONVOLUTION_AUTO, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_CONVOLUTION_HPP
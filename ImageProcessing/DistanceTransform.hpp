@@ -0,0 +1,197 @@
+/*	================================================================
+	The exact squared euclidean distance transform of a mask, after
+	P.F. Felzenszwalb and D.P. Huttenlocher, "Distance Transforms of
+	Sampled Functions", Theory of Computing 8 (2012).
+
+	Every pixel gets the squared distance to the nearest nonzero pixel
+	of the mask (a feature), and optionally the position of that
+	feature.
+
+	1) Columns: the nearest feature in the same column, by a downward
+	   then an upward scan. Each scan step is a flat loop across a
+	   whole row, and the columns are split among the threads.
+	2) Rows: with g(x) the column distance found in 1), the distance
+	   of pixel q is min over x of (q - x)^2 + g(x)^2, the lower
+	   envelope of parabolas, built and read in one left to right
+	   sweep. The rows are split among the threads.
+
+	Both passes are linear, the result is exact and does not depend on
+	the number of threads.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::Matrix<float> distance(mask.rows, mask.cols);
+		his::distance_transform(his::MatrixWrapper<uchar>(mask.data, mask.rows, mask.cols),
+			distance, 0);
+
+		// with the nearest feature of each pixel
+		his::Matrix<his::Idx> nearest(mask.rows, mask.cols);
+		his::distance_transform(mask_wrapper, distance, nearest, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols/threads)
+	Space complexity: rows*cols ints, plus O(cols) per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_DISTANCETRANSFORM_HPP
+#define HIS_IMAGEPROCESSING_DISTANCETRANSFORM_HPP
+
+#include <cassert>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "IdxMap.hpp"
+#include "Matrix.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	The shared passes: store(y, x, squared, nearest) receives every
+	pixel, with nearest == Idx(-1, -1) and an infinite distance when
+	the mask has no feature.
+*/
+template<class T, class StoreFunc>
+void distance_transform_rows(const MatrixWrapper<T> &mask, StoreFunc store, int threads)
+{
+	static_assert(std::is_arithmetic<T>::value, "the mask must have a single channel");
+
+	const int rows = mask.rows(), cols = mask.cols();
+
+	// the row of the nearest feature in each column, -1 for none
+	Matrix<int> nearest_row(rows, cols);
+	parallel_for(0, cols, threads, [&](int x0, int x1)
+	{
+		for (int y = 0; y < rows; ++y)
+		{
+			const T *m = mask[y];
+			const int *above = y > 0 ? nearest_row[y - 1] : 0;
+			int *n = nearest_row[y];
+			for (int x = x0; x < x1; ++x)
+				n[x] = m[x] != 0 ? y : (above ? above[x] : -1);
+		}
+
+		for (int y = rows - 2; y >= 0; --y)
+		{
+			const int *below = nearest_row[y + 1];
+			int *n = nearest_row[y];
+			for (int x = x0; x < x1; ++x)
+				if (below[x] >= 0 && (n[x] < 0 || below[x] - y < y - n[x]))
+					n[x] = below[x];
+		}
+	});
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		// the parabolas of the envelope, and their ranges [z[k], z[k+1])
+		std::vector<int> v(cols);
+		std::vector<long long> f(cols);
+		std::vector<double> z(cols + 1);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			const int *n = nearest_row[y];
+			int k = -1;
+			for (int q = 0; q < cols; ++q)
+			{
+				if (n[q] < 0)
+					continue;
+				f[q] = (long long)(y - n[q]) * (y - n[q]);
+				if (k < 0)
+				{
+					k = 0, v[0] = q;
+					z[0] = -std::numeric_limits<double>::infinity();
+					z[1] = std::numeric_limits<double>::infinity();
+					continue;
+				}
+
+				double s;
+				while (true)
+				{
+					int p = v[k];
+					s = (double(f[q] + (long long)q * q) - double(f[p] + (long long)p * p))
+						/ (2.0 * (q - p));
+					if (s > z[k])
+						break;
+					--k;
+				}
+				++k;
+				v[k] = q, z[k] = s;
+				z[k + 1] = std::numeric_limits<double>::infinity();
+			}
+
+			if (k < 0)
+			{
+				for (int q = 0; q < cols; ++q)
+					store(y, q, std::numeric_limits<double>::infinity(), Idx(-1, -1));
+				continue;
+			}
+
+			k = 0;
+			for (int q = 0; q < cols; ++q)
+			{
+				while (z[k + 1] < q)
+					++k;
+				int p = v[k];
+				store(y, q, double((long long)(q - p) * (q - p) + f[p]), Idx(p, n[p]));
+			}
+		}
+	});
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<T> mask:
+		The mask, of any scalar type, nonzero elements are features.
+	MatrixWrapper<Dst> distance:
+		The squared distance of each pixel to the nearest feature, with
+		the size of the mask. Pixels of a mask without features are
+		infinite, or the largest value of an integer Dst.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class T, class Dst>
+void distance_transform(const MatrixWrapper<T> mask, MatrixWrapper<Dst> distance,
+	int threads = 1)
+{
+	assert(mask.rows() == distance.rows() && mask.cols() == distance.cols());
+
+	distance_transform_rows(mask, [&](int y, int x, double squared, Idx)
+	{
+		distance[y][x] = saturate_cast<Dst>(squared);
+	}, threads);
+}
+
+
+/*
+	The same, with the position of the nearest feature of each pixel,
+	Idx(-1, -1) for a mask without features. Among features at the same
+	distance, any of them.
+*/
+template<class T, class Dst>
+void distance_transform(const MatrixWrapper<T> mask, MatrixWrapper<Dst> distance,
+	MatrixWrapper<Idx> nearest, int threads = 1)
+{
+	assert(mask.rows() == distance.rows() && mask.cols() == distance.cols());
+	assert(mask.rows() == nearest.rows() && mask.cols() == nearest.cols());
+
+	distance_transform_rows(mask, [&](int y, int x, double squared, Idx idx)
+	{
+		distance[y][x] = saturate_cast<Dst>(squared);
+		nearest[y][x] = idx;
+	}, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_DISTANCETRANSFORM_HPP
@@ -64,6 +64,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "Foreach.hpp"
 #include "Matrix.hpp"
@@ -0,0 +1,190 @@
+/*	================================================================
+	A bank of linear filters applied in one pass over the input.
+
+	Calling filter once per kernel reads the whole input once per
+	kernel. Here each input row is converted to float once, and each
+	neighborhood value is loaded once and accumulated against all the
+	kernels:
+
+		output_k(y, x) = sum kernel_k(ky, kx) * input(y - ry + ky, x - rx + kx)
+
+	This is a correlation, the orientation of filter() in Filter.hpp:
+	the kernels are not flipped. convolve() in Convolution.hpp flips
+	its kernel; for the same result, pass it the kernels rotated by
+	180 degrees. Pixels outside of the image are replicated from the
+	border.
+
+	The weights are interleaved kernel-major, the K weights of a tap
+	are contiguous, and so are the K accumulators of a pixel, which is
+	also the layout of a T[K] output.
+
+	The last krows input rows, padded by replicating the border
+	pixels, are kept in a ring buffer, so every input row is read and
+	converted once per thread. In parallel mode, each thread filters a
+	strip of rows.
+
+	================================================================
+
+	Usage:
+
+		std::vector<his::MatrixWrapper<float>> gabors = ...;	// 8 orientations, 15 x 15
+
+		// one matrix per kernel
+		std::vector<his::MatrixWrapper<float>> responses = ...;
+		his::filter_bank(gray_wrapper, responses, gabors, 0);
+
+		// or one channel per kernel
+		his::MatrixWrapper<float[8]> stacked(data, rows, cols);
+		his::filter_bank(gray_wrapper, stacked, gabors, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols*K*krows*kcols/threads)
+	Space complexity: O((cols + kcols)*krows + cols*K) floats per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_FILTERBANK_HPP
+#define HIS_IMAGEPROCESSING_FILTERBANK_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "MatrixWrapper.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	The shared pass: store(y, acc) receives for each output row the
+	cols*K interleaved responses, acc[x*K + k].
+*/
+template<class Src, class StoreFunc>
+void filter_bank_rows(const MatrixWrapper<Src> &input,
+	const std::vector<MatrixWrapper<float>> &kernels, StoreFunc store, int threads)
+{
+	static_assert(std::is_arithmetic<Src>::value, "filter_bank works on single channel images");
+	assert(!kernels.empty());
+
+	const int count = int(kernels.size());
+	const int krows = kernels[0].rows(), kcols = kernels[0].cols();
+	const int ry = krows / 2, rx = kcols / 2;
+	const int rows = input.rows(), cols = input.cols();
+	const int width = cols + 2 * rx;
+	assert(krows % 2 == 1 && kcols % 2 == 1);
+
+	std::vector<float> weights(krows * kcols * count);
+	for (int k = 0; k < count; ++k)
+	{
+		assert(kernels[k].rows() == krows && kernels[k].cols() == kcols);
+		for (int ky = 0; ky < krows; ++ky)
+			for (int kx = 0; kx < kcols; ++kx)
+				weights[(ky * kcols + kx) * count + k] = kernels[k][ky][kx];
+	}
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		// padded input row sy lives in slot (sy - first) % krows
+		std::vector<float> ring(krows * width), acc(cols * count);
+		const int first = y0 - ry;
+		auto load = [&](int sy)
+		{
+			const Src *src = input[std::min(std::max(sy, 0), rows - 1)];
+			float *dst = &ring[(sy - first) % krows * width];
+			for (int x = 0; x < width; ++x)
+				dst[x] = float(src[std::min(std::max(x - rx, 0), cols - 1)]);
+		};
+
+		for (int sy = first; sy < y0 + ry; ++sy)
+			load(sy);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			load(y + ry);
+			std::fill(acc.begin(), acc.end(), 0.f);
+
+			for (int ky = 0; ky < krows; ++ky)
+			{
+				const float *row = &ring[(y - ry + ky - first) % krows * width];
+				for (int kx = 0; kx < kcols; ++kx)
+				{
+					const float *w = &weights[(ky * kcols + kx) * count];
+					const float *p = row + kx;
+					float *a = &acc[0];
+					for (int x = 0; x < cols; ++x, a += count)
+					{
+						const float v = p[x];
+						for (int k = 0; k < count; ++k)
+							a[k] += w[k] * v;
+					}
+				}
+			}
+
+			store(y, &acc[0]);
+		}
+	});
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> input:
+		The input image, of any scalar type.
+	std::vector<MatrixWrapper<Dst>> outputs:
+		One output image per kernel, with the size of the input. Integer
+		outputs are rounded and saturated, see Convert.hpp.
+	const std::vector<MatrixWrapper<float>> &kernels:
+		The kernels, all with the same odd size.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void filter_bank(const MatrixWrapper<Src> input, std::vector<MatrixWrapper<Dst>> outputs,
+	const std::vector<MatrixWrapper<float>> &kernels, int threads = 1)
+{
+	static_assert(std::is_arithmetic<Dst>::value, "use a Dst[K] output for interleaved responses");
+	assert(outputs.size() == kernels.size());
+	for (size_t k = 0; k < outputs.size(); ++k)
+		assert(outputs[k].rows() == input.rows() && outputs[k].cols() == input.cols());
+
+	const int count = int(kernels.size()), cols = input.cols();
+	filter_bank_rows(input, kernels, [&](int y, const float *acc)
+	{
+		for (int k = 0; k < count; ++k)
+		{
+			Dst *dst = outputs[k][y];
+			for (int x = 0; x < cols; ++x)
+				dst[x] = saturate_cast<Dst>(acc[x * count + k]);
+		}
+	}, threads);
+}
+
+
+/*
+	The same, with the response to kernel k in channel k of a single
+	Dst[K] output.
+*/
+template<class Src, class Dst, size_t K>
+void filter_bank(const MatrixWrapper<Src> input, MatrixWrapper<Dst[K]> output,
+	const std::vector<MatrixWrapper<float>> &kernels, int threads = 1)
+{
+	assert(kernels.size() == K);
+	assert(output.rows() == input.rows() && output.cols() == input.cols());
+
+	const int count = int(K * input.cols());
+	filter_bank_rows(input, kernels, [&](int y, const float *acc)
+	{
+		Dst *dst = reinterpret_cast<Dst *>(output[y]);
+		for (int i = 0; i < count; ++i)
+			dst[i] = saturate_cast<Dst>(acc[i]);
+	}, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_FILTERBANK_HPP
@@ -0,0 +1,283 @@
+/*	================================================================
+	Searches over matrices which stop as soon as the answer is known,
+	unlike for_each, whose functor cannot stop the iteration.
+
+	find_if returns the position of the first corresponding elements
+	(in row-major order) satisfying a predicate, or Idx(-1, -1) if
+	there is none. any_of and all_of answer with a bool.
+
+	Inputs:
+		Mat1 mat1[, [Mat2 mat2, ... Mat4 mat4]]:
+			Matrices to search, including IdxMap.
+		PredFunc pred:
+			A functor taking corresponding elements, returning a bool.
+		int threads:
+			Number of threads, 0 for all cores. See Parallel.hpp.
+
+	In parallel mode, the threads take small blocks of rows in
+	increasing order. Once a thread finds a match, the others give up
+	the rows below it, only the rows above it are still searched, so
+	the result is the same as the single threaded one.
+
+	================================================================
+
+	Usage:
+
+		bool has_nan = his::any_of(depth, [](float d) { return d != d; });
+
+		his::Idx first = his::find_if(mask, [](uchar m) { return m != 0; }, 0);
+		if (first.x >= 0)
+			...
+*/
+
+#ifndef HIS_IMAGEPROCESSING_FIND_HPP
+#define HIS_IMAGEPROCESSING_FIND_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#include "IdxMap.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+// number of rows a thread takes at once in parallel mode
+const int find_block_rows = 8;
+
+
+/*
+	The common part of the searches: row_func(y) returns the column of
+	the first match in row y, or -1.
+*/
+template<class RowFunc>
+Idx find_rows(int rows, RowFunc row_func, int threads)
+{
+	int blocks = (rows + find_block_rows - 1) / find_block_rows;
+	int chunks = thread_count(threads, blocks);
+	if (chunks == 1)
+	{
+		for (int y = 0; y < rows; ++y)
+		{
+			int x = row_func(y);
+			if (x >= 0)
+				return Idx(x, y);
+		}
+		return Idx(-1, -1);
+	}
+
+	// the best match so far as y * 2^32 + x, rows if none
+	const int64_t none = int64_t(rows) << 32;
+	std::atomic<int64_t> best(none);
+	std::atomic<int> next_block(0);
+
+	parallel_chunks(0, chunks, chunks, [&](int, int, int)
+	{
+		while (true)
+		{
+			int y0 = next_block.fetch_add(1, std::memory_order_relaxed) * find_block_rows;
+			int y1 = y0 + find_block_rows < rows ? y0 + find_block_rows : rows;
+			for (int y = y0; y < y1; ++y)
+			{
+				// a match was found above, nothing to search here
+				if ((best.load(std::memory_order_relaxed) >> 32) < y)
+					return;
+
+				int x = row_func(y);
+				if (x < 0)
+					continue;
+
+				int64_t found = (int64_t(y) << 32) + x;
+				int64_t current = best.load(std::memory_order_relaxed);
+				while (found < current && !best.compare_exchange_weak(current, found,
+					std::memory_order_relaxed))
+					;
+				return;
+			}
+			if (y1 >= rows)
+				return;
+		}
+	});
+
+	int64_t result = best.load();
+	if (result == none)
+		return Idx(-1, -1);
+	return Idx(int(result & 0xffffffff), int(result >> 32));
+}
+
+
+template<class Mat1, class PredFunc>
+Idx find_if(Mat1 mat, PredFunc pred, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+
+	return find_rows(mat.rows(), [&](int y) -> int
+	{
+		auto p = mat[y];
+		for (int x = 0; x < mat.cols(); ++x)
+		{
+			if (pred(*p))
+				return x;
+			p += 1;
+		}
+		return -1;
+	}, threads);
+}
+
+
+// 2 matrices
+template<class Mat1, class Mat2, class PredFunc>
+Idx find_if(Mat1 mat1, Mat2 mat2, PredFunc pred, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+
+	return find_rows(mat1.rows(), [&](int y) -> int
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		for (int x = 0; x < mat1.cols(); ++x)
+		{
+			if (pred(*p1, *p2))
+				return x;
+			p1 += 1, p2 += 1;
+		}
+		return -1;
+	}, threads);
+}
+
+
+// 3 matrices
+template<class Mat1, class Mat2, class Mat3, class PredFunc>
+Idx find_if(Mat1 mat1, Mat2 mat2, Mat3 mat3, PredFunc pred, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+
+	return find_rows(mat1.rows(), [&](int y) -> int
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		auto p3 = mat3[y];
+		for (int x = 0; x < mat1.cols(); ++x)
+		{
+			if (pred(*p1, *p2, *p3))
+				return x;
+			p1 += 1, p2 += 1, p3 += 1;
+		}
+		return -1;
+	}, threads);
+}
+
+
+// 4 matrices
+template<class Mat1, class Mat2, class Mat3, class Mat4, class PredFunc>
+Idx find_if(Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, PredFunc pred, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+    assert(Mat4::FOR_EACH_ABLE == Mat4::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+	assert(mat1.rows() == mat4.rows() && mat1.cols() == mat4.cols());
+
+	return find_rows(mat1.rows(), [&](int y) -> int
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		auto p3 = mat3[y];
+		auto p4 = mat4[y];
+		for (int x = 0; x < mat1.cols(); ++x)
+		{
+			if (pred(*p1, *p2, *p3, *p4))
+				return x;
+			p1 += 1, p2 += 1, p3 += 1, p4 += 1;
+		}
+		return -1;
+	}, threads);
+}
+
+
+template<class Mat1, class PredFunc>
+bool any_of(Mat1 mat, PredFunc pred, int threads = 1)
+{
+	return find_if(mat, pred, threads).x >= 0;
+}
+
+
+template<class Mat1, class Mat2, class PredFunc>
+bool any_of(Mat1 mat1, Mat2 mat2, PredFunc pred, int threads = 1)
+{
+	return find_if(mat1, mat2, pred, threads).x >= 0;
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class PredFunc>
+bool any_of(Mat1 mat1, Mat2 mat2, Mat3 mat3, PredFunc pred, int threads = 1)
+{
+	return find_if(mat1, mat2, mat3, pred, threads).x >= 0;
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class Mat4, class PredFunc>
+bool any_of(Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, PredFunc pred, int threads = 1)
+{
+	return find_if(mat1, mat2, mat3, mat4, pred, threads).x >= 0;
+}
+
+
+// the negation of a predicate, for all_of
+template<class PredFunc>
+struct NotPredicate
+{
+	PredFunc pred;
+
+	template<class... Elements>
+	bool operator ()(Elements &&...elements) { return !pred(elements...); }
+};
+
+
+template<class Mat1, class PredFunc>
+bool all_of(Mat1 mat, PredFunc pred, int threads = 1)
+{
+	NotPredicate<PredFunc> not_pred = { pred };
+	return find_if(mat, not_pred, threads).x < 0;
+}
+
+
+template<class Mat1, class Mat2, class PredFunc>
+bool all_of(Mat1 mat1, Mat2 mat2, PredFunc pred, int threads = 1)
+{
+	NotPredicate<PredFunc> not_pred = { pred };
+	return find_if(mat1, mat2, not_pred, threads).x < 0;
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class PredFunc>
+bool all_of(Mat1 mat1, Mat2 mat2, Mat3 mat3, PredFunc pred, int threads = 1)
+{
+	NotPredicate<PredFunc> not_pred = { pred };
+	return find_if(mat1, mat2, mat3, not_pred, threads).x < 0;
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class Mat4, class PredFunc>
+bool all_of(Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, PredFunc pred, int threads = 1)
+{
+	NotPredicate<PredFunc> not_pred = { pred };
+	return find_if(mat1, mat2, mat3, mat4, not_pred, threads).x < 0;
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_FIND_HPP
@@ -0,0 +1,205 @@
+/*	================================================================
+	A fixed-point linear filter for 8-bit images.
+
+	The float path of `filter` converts every 8-bit tap to float. Here
+	the kernel is quantized once to 16-bit integers summing to
+	1 << shift, the taps are accumulated in 32-bit integers (64-bit
+	for kernels whose sum could overflow them), and the result is
+	rounded back to 8-bit exactly:
+
+		output = saturate((sum(w * input) + (1 << (shift - 1))) >> shift)
+
+	With integer accumulation the result does not depend on the order
+	of the taps, and the only error compared to the real valued filter
+	comes from the quantization of the weights.
+
+	Each output row is computed as a sum of shifted source rows, one
+	flat loop over cols*N values per tap, which the compiler vectorizes.
+	The source rows are padded by replicating the border pixels, so the
+	kernel is never trimmed at the border (unlike `filter`, which
+	renormalizes the trimmed kernel).
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::Matrix<short> kernel = his::quantize_kernel(
+			his::gaussian_kernel<float>(11, 11, 10), 14);
+
+		his::filter_fixed(his::MatrixWrapper<uchar[3]>(image.data, image.rows, image.cols),
+			his::MatrixWrapper<uchar[3]>(blur.data, blur.rows, blur.cols),
+			kernel, 14, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols*N*krows*kcols/threads)
+	Space complexity: O((cols + kcols)*N) per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_FIXEDPOINTFILTER_HPP
+#define HIS_IMAGEPROCESSING_FIXEDPOINTFILTER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "Matrix.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Quantize a kernel to fixed-point weights summing to 1 << shift.
+
+	Inputs:
+	const MatrixWrapper<T> kernel:
+		A kernel of any arithmetic type, its sum must not be 0.
+	int shift:
+		Number of fractional bits, in [1, 14].
+
+	Output:
+	The quantized kernel. The rounding residual of the weights is given
+	to the center weight, so the sum is exact and a flat image stays
+	unchanged.
+*/
+template<class T>
+Matrix<short> quantize_kernel(const MatrixWrapper<T> kernel, int shift)
+{
+	assert(shift >= 1 && shift <= 14);
+
+	double sum = 0;
+	for (int y = 0; y < kernel.rows(); ++y)
+		for (int x = 0; x < kernel.cols(); ++x)
+			sum += kernel[y][x];
+	assert(sum != 0);
+
+	const int one = 1 << shift;
+	Matrix<short> quantized(kernel.rows(), kernel.cols());
+	int total = 0;
+	for (int y = 0; y < kernel.rows(); ++y)
+	{
+		for (int x = 0; x < kernel.cols(); ++x)
+		{
+			quantized[y][x] = saturate_cast<short>(kernel[y][x] * one / sum);
+			total += quantized[y][x];
+		}
+	}
+	short &center = quantized[kernel.rows() / 2][kernel.cols() / 2];
+	center = saturate_cast<short>(center + one - total);
+	return quantized;
+}
+
+
+/*
+	The rows [y0, y1) of filter_fixed, accumulated in Acc.
+*/
+template<class Acc, class T>
+void filter_fixed_rows(const MatrixWrapper<T> &input, MatrixWrapper<T> &output,
+	const MatrixWrapper<short> &kernel, int shift, int y0, int y1)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	const int channels = int(sizeof(T));
+	const int ry = kernel.rows() / 2, rx = kernel.cols() / 2;
+	const int count = input.cols() * channels;
+	const Acc half = Acc(1) << (shift - 1);
+
+	std::vector<Scalar> padded((input.cols() + 2 * rx) * channels);
+	std::vector<Acc> acc(count);
+
+	for (int y = y0; y < y1; ++y)
+	{
+		std::fill(acc.begin(), acc.end(), Acc(0));
+		for (int ky = 0; ky < kernel.rows(); ++ky)
+		{
+			// the source row, with its border pixels replicated
+			int sy = std::min(std::max(y + ky - ry, 0), input.rows() - 1);
+			const Scalar *src = reinterpret_cast<const Scalar *>(input[sy]);
+			Scalar *row = &padded[0];
+			for (int x = 0; x < rx; ++x)
+			{
+				memcpy(row + x * channels, src, channels);
+				memcpy(row + (rx + input.cols() + x) * channels,
+					src + count - channels, channels);
+			}
+			memcpy(row + rx * channels, src, count);
+
+			const short *weights = kernel[ky];
+			Acc *sum = &acc[0];
+			for (int kx = 0; kx < kernel.cols(); ++kx)
+			{
+				const Acc w = weights[kx];
+				if (w == 0)
+					continue;
+				const Scalar *p = row + kx * channels;
+				for (int i = 0; i < count; ++i)
+					sum[i] += w * p[i];
+			}
+		}
+
+		Scalar *dst = reinterpret_cast<Scalar *>(output[y]);
+		for (int i = 0; i < count; ++i)
+			dst[i] = saturate_cast<Scalar>((acc[i] + half) >> shift);
+	}
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<T> input:
+		The input image, T is unsigned char or unsigned char[N].
+	MatrixWrapper<T> output:
+		The output image, with the same size. Must not be the input.
+	const MatrixWrapper<short> kernel:
+		A quantized kernel with odd sizes, see quantize_kernel.
+	int shift: The shift the kernel was quantized with.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+
+	The taps are accumulated in 32-bit integers when the largest
+	possible sum, sum(|w|) * 255, fits in them, which holds for any
+	kernel of up to 257 taps. Larger kernels, or signed ones with large
+	weights, are accumulated in 64-bit integers instead.
+*/
+template<class T>
+void filter_fixed(const MatrixWrapper<T> input, MatrixWrapper<T> output,
+	const MatrixWrapper<short> kernel, int shift, int threads = 1)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	static_assert(std::is_same<Scalar, unsigned char>::value,
+		"filter_fixed works on 8-bit images");
+
+	assert(kernel.rows() % 2 == 1 && kernel.cols() % 2 == 1);
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	if (input.rows() == 0 || input.cols() == 0)
+		return;
+	assert(input[0] != output[0]);
+	assert(shift >= 1 && shift <= 14);
+
+	// the bound of |sum(w * input) + half|
+	long long bound = 1LL << (shift - 1);
+	for (int ky = 0; ky < kernel.rows(); ++ky)
+		for (int kx = 0; kx < kernel.cols(); ++kx)
+			bound += std::abs(int(kernel[ky][kx])) * 255LL;
+	const bool wide = bound > std::numeric_limits<int>::max();
+
+	parallel_for(0, input.rows(), threads, [&](int y0, int y1)
+	{
+		if (wide)
+			filter_fixed_rows<long long>(input, output, kernel, shift, y0, y1);
+		else
+			filter_fixed_rows<int>(input, output, kernel, shift, y0, y1);
+	});
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_FIXEDPOINTFILTER_HPP
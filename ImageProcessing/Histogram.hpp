@@ -0,0 +1,205 @@
+/*	================================================================
+	Histograms of 8-bit, 16-bit and floating point images, with one
+	or more channels, optionally restricted to a RunLengthMask.
+
+	A value v falls into bin floor((v - lo) * bins / (hi - lo)), the
+	values outside of [lo, hi) are not counted. For T[N] elements,
+	every channel has its own histogram, and the result holds the N
+	histograms one after another: result[c * bins + b].
+
+	Every thread counts its band of rows into a private histogram, so
+	the threads never write to the same bins. For 8-bit data, where a
+	few hot bins are hit over and over, each thread further spreads
+	consecutive pixels over 4 sub-histograms (lanes), so increments of
+	the same bin do not wait for each other. All sub-histograms are
+	summed at the end.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		// 256 bins for the gray levels
+		std::vector<int> hist = his::histogram(
+			his::MatrixWrapper<uchar>(gray.data, gray.rows, gray.cols),
+			256, 0, 256);
+
+		// 3 histograms of 32 bins, inside a region, using all cores
+		std::vector<int> rgb_hist = his::histogram(his::RunLengthMask(roi),
+			his::MatrixWrapper<uchar[3]>(image.data, image.rows, image.cols),
+			32, 0, 256, 0);
+
+		// the green histogram
+		int *green = &rgb_hist[1 * 32];
+
+	================================================================
+
+	Time complexity: O(rows*cols*N/threads + threads*N*bins)
+	Space complexity: O(threads*N*bins), 4 times more for 8-bit data
+*/
+
+#ifndef HIS_IMAGEPROCESSING_HISTOGRAM_HPP
+#define HIS_IMAGEPROCESSING_HISTOGRAM_HPP
+
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+#include "MatrixWrapper.hpp"
+#include "RunLengthMask.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Maps a scalar value to its bin, or to `bins` (the discarded slot)
+	if it is out of range, so the counting loop has no branch.
+*/
+template<class Scalar>
+class HistogramBinning
+{
+public:
+	HistogramBinning(int bins, double lo, double hi)
+		: m_bins(bins), m_lo(lo), m_scale(bins / (hi - lo))
+	{}
+
+	int operator ()(Scalar v) const
+	{
+		// NaN fails both comparisons
+		double t = (double(v) - m_lo) * m_scale;
+		return t >= 0 && t < m_bins ? int(t) : m_bins;
+	}
+
+private:
+	int m_bins;
+	double m_lo, m_scale;
+};
+
+
+// 8-bit values are binned through a lookup table
+template<>
+class HistogramBinning<unsigned char>
+{
+public:
+	HistogramBinning(int bins, double lo, double hi)
+	{
+		HistogramBinning<int> binning(bins, lo, hi);
+		for (int v = 0; v < 256; ++v)
+			m_table[v] = binning(v);
+	}
+
+	int operator ()(unsigned char v) const
+	{
+		return m_table[v];
+	}
+
+private:
+	int m_table[256];
+};
+
+
+/*
+	The common part of the histograms, mask may be null to count the
+	whole image.
+*/
+template<class T>
+std::vector<int> histogram_runs(const RunLengthMask *mask, const MatrixWrapper<T> &mat,
+	int bins, double lo, double hi, int threads)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	const int channels = std::extent<T>::value > 0 ? int(std::extent<T>::value) : 1;
+	const int lanes = sizeof(Scalar) == 1 ? 4 : 1;
+
+	assert(bins > 0 && lo < hi);
+	assert(!mask || (mask->rows() == mat.rows() && mask->cols() == mat.cols()));
+
+	// one more slot per histogram for the values out of range
+	const int stride = bins + 1;
+	HistogramBinning<Scalar> binning(bins, lo, hi);
+
+	int chunks = thread_count(threads, mat.rows());
+	std::vector<std::vector<int>> partials(chunks);
+
+	parallel_chunks(0, mat.rows(), chunks, [&](int chunk, int y0, int y1)
+	{
+		std::vector<int> &partial = partials[chunk];
+		partial.assign(lanes * channels * stride, 0);
+		int *hist = &partial[0];
+
+		for (int y = y0; y < y1; ++y)
+		{
+			const Scalar *row = reinterpret_cast<const Scalar *>(mat[y]);
+			auto count = [&](int x0, int x1)
+			{
+				const Scalar *p = row + x0 * channels;
+				int x = x0;
+				for (; x + lanes <= x1; x += lanes)
+				{
+					for (int l = 0; l < lanes; ++l, p += channels)
+						for (int c = 0; c < channels; ++c)
+							++hist[(l * channels + c) * stride + binning(p[c])];
+				}
+				for (; x < x1; ++x, p += channels)
+					for (int c = 0; c < channels; ++c)
+						++hist[c * stride + binning(p[c])];
+			};
+
+			if (!mask)
+				count(0, mat.cols());
+			else
+				for (const RunLengthMask::Run *run = mask->begin(y); run != mask->end(y); ++run)
+					count(run->x0, run->x1);
+		}
+	});
+
+	// sum the lanes and threads, dropping the out of range slots
+	std::vector<int> result(channels * bins, 0);
+	for (int chunk = 0; chunk < chunks; ++chunk)
+		for (int l = 0; l < lanes; ++l)
+			for (int c = 0; c < channels; ++c)
+			{
+				const int *hist = &partials[chunk][(l * channels + c) * stride];
+				for (int b = 0; b < bins; ++b)
+					result[c * bins + b] += hist[b];
+			}
+	return result;
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<T> mat:
+		The image, T is unsigned char, unsigned short, float, etc., or
+		an array of them for multiple channels, e.g. unsigned char[3].
+	int bins: Number of bins per channel.
+	double lo, double hi: The range of values [lo, hi) to count.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+
+	Output:
+	The counts of each bin, the histogram of channel c starts at c * bins.
+*/
+template<class T>
+std::vector<int> histogram(const MatrixWrapper<T> mat, int bins, double lo, double hi,
+	int threads = 1)
+{
+	return histogram_runs<T>(nullptr, mat, bins, lo, hi, threads);
+}
+
+
+/*
+	The same, only counting the pixels inside the mask.
+*/
+template<class T>
+std::vector<int> histogram(const RunLengthMask &mask, const MatrixWrapper<T> mat, int bins,
+	double lo, double hi, int threads = 1)
+{
+	return histogram_runs<T>(&mask, mat, bins, lo, hi, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_HISTOGRAM_HPP
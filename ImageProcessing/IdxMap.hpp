@@ -36,6 +36,7 @@ struct Idx
 {
 	enum Step {};
 	int x, y;
+	Idx() : x(0), y(0) {}
 	Idx(int _x, int _y) : x(_x), y(_y) {}
 };
 
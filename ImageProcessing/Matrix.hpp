@@ -37,9 +37,10 @@ public:
 	void create(int rows, int cols)
 	{
 		this->m_rows = rows, this->m_cols = this->m_step = cols;
-		m_data = std::shared_ptr<T>(new T[rows * cols], 
-			[](const T *p) { delete []p;});
-		this->m_start = m_data.get();
+		// untyped, so that T can be an array for multiple channels
+		T *data = new T[rows * cols];
+		m_data = std::shared_ptr<void>(data, [](T *p) { delete []p;});
+		this->m_start = data;
 	}
 
 	/*
@@ -72,7 +73,7 @@ public:
 	}
 
 protected:
-	std::shared_ptr<T>	m_data;
+	std::shared_ptr<void>	m_data;
 };
 
 
@@ -0,0 +1,273 @@
+/*	================================================================
+	Median and rank (percentile) filters over a square window of
+	radius r, for 8-bit and 16-bit images, with one or more channels.
+
+	8-bit images follow S. Perreault and P. Hebert, "Median Filtering
+	in Constant Time", IEEE Trans. Image Processing 16 (2007):
+	1) Every column keeps the histogram of its 2r+1 pixels in the
+	   window rows. Moving down one row removes one pixel and adds one
+	   to each column histogram.
+	2) The window histogram is the sum of 2r+1 column histograms.
+	   Moving right one pixel adds the entering column histogram and
+	   subtracts the leaving one, a fixed number of operations.
+	3) The rank is found through a coarse histogram of 16 bins, then
+	   the 16 fine bins of the selected coarse bin.
+	So the cost per pixel does not depend on r.
+
+	16-bit images would need 65536 bins per column, so they follow the
+	sliding window of T. Huang instead: the window histogram is
+	updated with the 2r+1 pixels entering and leaving at each step,
+	and the rank is found through 256 coarse bins of 256 fine bins.
+	The cost per pixel is O(r) there.
+
+	The borders are handled by replicating the edge pixels. In
+	parallel mode, each thread filters a strip of rows with its own
+	histograms.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::median_filter(his::MatrixWrapper<uchar[3]>(image.data, image.rows, image.cols),
+			his::MatrixWrapper<uchar[3]>(denoised.data, denoised.rows, denoised.cols),
+			15, 0);
+
+		// the 90th percentile of a depth map
+		his::rank_filter(depth_wrapper, upper_wrapper, 5, 0.9);
+
+	================================================================
+
+	Time complexity:
+		8-bit: O(rows*cols*N/threads), plus O(r) per row
+		16-bit: O(rows*cols*N*r/threads)
+	Space complexity:
+		8-bit: 544 bytes per column, per thread
+		16-bit: 256K per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_MEDIANFILTER_HPP
+#define HIS_IMAGEPROCESSING_MEDIANFILTER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "MatrixWrapper.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	Replicated border access to channel c of a T or T[N] matrix.
+*/
+template<class T>
+class RankFilterSource
+{
+public:
+	typedef typename std::remove_all_extents<T>::type Scalar;
+
+	RankFilterSource(const MatrixWrapper<T> &input, int c)
+		: m_input(input), m_channel(c)
+		, m_channels(int(sizeof(T) / sizeof(Scalar)))
+	{}
+
+	int operator ()(int y, int x) const
+	{
+		y = std::min(std::max(y, 0), m_input.rows() - 1);
+		x = std::min(std::max(x, 0), m_input.cols() - 1);
+		return reinterpret_cast<const Scalar *>(m_input[y])[x * m_channels + m_channel];
+	}
+
+	int cols() const { return m_input.cols(); }
+
+private:
+	const MatrixWrapper<T> &m_input;
+	int m_channel, m_channels;
+};
+
+
+/*
+	Output:
+		The value of the given rank (0 based) in a two level histogram,
+		where coarse[j] sums fine[j*width, (j+1)*width).
+*/
+inline int rank_in_histogram(const int *coarse, const int *fine, int width, int rank)
+{
+	int j = 0;
+	while (coarse[j] <= rank)
+		rank -= coarse[j++];
+	int i = j * width;
+	while (fine[i] <= rank)
+		rank -= fine[i++];
+	return i;
+}
+
+
+// 8-bit, constant time per pixel with column histograms
+template<class T, class Store>
+void rank_filter_rows(const RankFilterSource<T> &pixel, Store store, int radius, int rank,
+	int y0, int y1, std::integral_constant<int, 1>)
+{
+	const int cols = pixel.cols();
+	std::vector<uint16_t> column(cols * 256, 0), column_coarse(cols * 16, 0);
+	int kernel[256], coarse[16];
+
+	auto update = [&](int y, int x, int delta)
+	{
+		int v = pixel(y, x);
+		column[x * 256 + v] += delta;
+		column_coarse[x * 16 + v / 16] += delta;
+	};
+
+	for (int x = 0; x < cols; ++x)
+		for (int dy = -radius; dy <= radius; ++dy)
+			update(y0 + dy, x, 1);
+
+	for (int y = y0; y < y1; ++y)
+	{
+		if (y > y0)
+		{
+			for (int x = 0; x < cols; ++x)
+			{
+				update(y - radius - 1, x, -1);
+				update(y + radius, x, 1);
+			}
+		}
+
+		std::fill(kernel, kernel + 256, 0);
+		std::fill(coarse, coarse + 16, 0);
+		for (int dx = -radius; dx <= radius; ++dx)
+		{
+			int x = std::min(std::max(dx, 0), cols - 1);
+			for (int i = 0; i < 256; ++i)
+				kernel[i] += column[x * 256 + i];
+			for (int j = 0; j < 16; ++j)
+				coarse[j] += column_coarse[x * 16 + j];
+		}
+
+		for (int x = 0; x < cols; ++x)
+		{
+			store(y, x, rank_in_histogram(coarse, kernel, 16, rank));
+
+			int enter = std::min(x + radius + 1, cols - 1);
+			int leave = std::max(x - radius, 0);
+			if (enter == leave)
+				continue;
+			const uint16_t *e = &column[enter * 256], *l = &column[leave * 256];
+			for (int i = 0; i < 256; ++i)
+				kernel[i] += e[i] - l[i];
+			const uint16_t *ce = &column_coarse[enter * 16], *cl = &column_coarse[leave * 16];
+			for (int j = 0; j < 16; ++j)
+				coarse[j] += ce[j] - cl[j];
+		}
+	}
+}
+
+
+// 16-bit, O(r) per pixel with a sliding window histogram
+template<class T, class Store>
+void rank_filter_rows(const RankFilterSource<T> &pixel, Store store, int radius, int rank,
+	int y0, int y1, std::integral_constant<int, 2>)
+{
+	const int cols = pixel.cols();
+	std::vector<int> fine(65536, 0), coarse(256, 0);
+
+	auto update = [&](int y, int x, int delta)
+	{
+		int v = pixel(y, x);
+		fine[v] += delta;
+		coarse[v >> 8] += delta;
+	};
+
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int dy = -radius; dy <= radius; ++dy)
+			for (int dx = -radius; dx <= radius; ++dx)
+				update(y + dy, dx, 1);
+
+		for (int x = 0; x < cols; ++x)
+		{
+			store(y, x, rank_in_histogram(&coarse[0], &fine[0], 256, rank));
+			for (int dy = -radius; dy <= radius; ++dy)
+			{
+				update(y + dy, x - radius, -1);
+				update(y + dy, x + radius + 1, 1);
+			}
+		}
+
+		// empty the histograms for the next row
+		for (int dy = -radius; dy <= radius; ++dy)
+			for (int dx = -radius; dx <= radius; ++dx)
+				update(y + dy, cols + dx, -1);
+	}
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<T> input:
+		The input image, T is unsigned char or unsigned short, or an
+		array of them for multiple channels.
+	MatrixWrapper<T> output:
+		The output image, with the same size. Must not be the input.
+	int radius: The window is (2*radius+1) x (2*radius+1).
+	double percentile:
+		In [0, 1], 0 for the minimum, 0.5 for the median, 1 for the
+		maximum.
+	int threads:
+		Number of threads (strips), 0 for all cores. See Parallel.hpp.
+*/
+template<class T>
+void rank_filter(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius,
+	double percentile, int threads = 1)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	static_assert(std::is_same<Scalar, unsigned char>::value
+		|| std::is_same<Scalar, unsigned short>::value,
+		"rank_filter works on 8-bit and 16-bit images");
+	const int channels = int(sizeof(T) / sizeof(Scalar));
+
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	if (input.rows() == 0 || input.cols() == 0)
+		return;
+	assert(input[0] != output[0]);
+	assert(radius >= 0 && radius < 128);
+	assert(percentile >= 0 && percentile <= 1);
+
+	int size = (2 * radius + 1) * (2 * radius + 1);
+	int rank = int(percentile * (size - 1) + 0.5);
+
+	parallel_for(0, input.rows(), threads, [&](int y0, int y1)
+	{
+		for (int c = 0; c < channels; ++c)
+		{
+			auto store = [&](int y, int x, int v)
+			{
+				reinterpret_cast<Scalar *>(output[y])[x * channels + c] = Scalar(v);
+			};
+			rank_filter_rows(RankFilterSource<T>(input, c), store, radius, rank, y0, y1,
+				std::integral_constant<int, int(sizeof(Scalar))>());
+		}
+	});
+}
+
+
+/*
+	The median filter, see rank_filter.
+*/
+template<class T>
+void median_filter(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius,
+	int threads = 1)
+{
+	rank_filter(input, output, radius, 0.5, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_MEDIANFILTER_HPP
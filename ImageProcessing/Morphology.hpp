@@ -0,0 +1,417 @@
+/*	================================================================
+	Morphological erosion, dilation, opening and closing, with a
+	rectangular or an arbitrary structuring element.
+
+	Rectangles are separable: a horizontal min (or max) over 2rx+1
+	pixels, then a vertical one over 2ry+1 pixels. Each line pass uses
+	the algorithm of M. van Herk (1992) and J. Gil and M. Werman (1993):
+	the line is cut into blocks of the window length L, and with g the
+	running min from the start of each block and h the running min
+	from its end, the window starting at i is
+
+		min(h[i], g[i + L - 1])
+
+	that is 3 comparisons per pixel, whatever L is.
+
+	The vertical pass handles whole rows at a time, so every step is a
+	flat loop across the columns, which the compiler vectorizes, and
+	the columns are split among the threads.
+
+	An arbitrary structuring element is decomposed into horizontal
+	runs (lines). The image is eroded once per distinct run length with
+	the horizontal pass, and every output pixel takes the min over the
+	runs of that length, shifted to their positions, before the next
+	length is computed in the same buffer.
+
+	Pixels outside of the image are replicated from the border, which
+	does not change the min and max of the pixels inside.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::MatrixWrapper<uchar> mask_wrapper(mask.data, mask.rows, mask.cols);
+
+		// remove the specks smaller than a 5x5 square
+		his::opening(mask_wrapper, mask_wrapper, 2, 2, 0);
+
+		// dilate with a disk of radius 7
+		his::Matrix<uchar> disk(15, 15);
+		his::for_each(disk, his::IdxMap(disk), [](uchar &d, his::Idx idx)
+		{
+			d = (idx.x - 7) * (idx.x - 7) + (idx.y - 7) * (idx.y - 7) <= 49;
+		});
+		his::dilate(mask_wrapper, mask_wrapper, disk);
+
+	================================================================
+
+	Time complexity:
+		rectangle: O(rows*cols*N/threads), independent of the size
+		element: O(rows*cols*N*(lengths + runs)/threads)
+	Space complexity:
+		rectangle: rows*cols*N elements, plus O(ry*cols*N) per thread
+		element: 2 images of rows*(cols + element cols)*N elements at
+		most, whatever the number of distinct run lengths
+*/
+
+#ifndef HIS_IMAGEPROCESSING_MORPHOLOGY_HPP
+#define HIS_IMAGEPROCESSING_MORPHOLOGY_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+#include "MatrixWrapper.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+struct MorphologyMin
+{
+	template<class S>
+	S operator ()(S a, S b) const { return b < a ? b : a; }
+};
+
+struct MorphologyMax
+{
+	template<class S>
+	S operator ()(S a, S b) const { return a < b ? b : a; }
+};
+
+
+/*
+	The van Herk/Gil-Werman pass over a line of n elements of
+	`channels` scalars, with stride `channels`: out[i] combines
+	line[i, i + length) for i in [0, n - length].
+	g and h are buffers of n*channels scalars.
+*/
+template<class Scalar, class Op>
+void van_herk_line(const Scalar *line, int n, int channels, int length,
+	Scalar *g, Scalar *h, Scalar *out, Op op)
+{
+	for (int b = 0; b < n; b += length)
+	{
+		int e = std::min(b + length, n);
+		for (int c = 0; c < channels; ++c)
+		{
+			g[b * channels + c] = line[b * channels + c];
+			for (int i = b + 1; i < e; ++i)
+				g[i * channels + c] = op(g[(i - 1) * channels + c], line[i * channels + c]);
+
+			h[(e - 1) * channels + c] = line[(e - 1) * channels + c];
+			for (int i = e - 2; i >= b; --i)
+				h[i * channels + c] = op(h[(i + 1) * channels + c], line[i * channels + c]);
+		}
+	}
+	for (int i = 0; i + length <= n; ++i)
+		for (int c = 0; c < channels; ++c)
+			out[i * channels + c] = op(h[i * channels + c], g[(i + length - 1) * channels + c]);
+}
+
+
+/*
+	Horizontal line pass over rows [y0, y1): column x of the output row
+	combines the source pixels [x + shift, x + shift + length) of row
+	y, replicated at the borders. Output rows have dst_cols pixels, the
+	one of row y starts at dst + (y - y0) * dst_step.
+*/
+template<class T, class Op>
+void morphology_rows(const MatrixWrapper<T> &src, typename std::remove_all_extents<T>::type *dst,
+	size_t dst_step, int dst_cols, int shift, int length, int y0, int y1, Op op)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	const int channels = int(sizeof(T) / sizeof(Scalar));
+	const int cols = src.cols();
+	const int n = dst_cols + length - 1;
+
+	std::vector<Scalar> padded(n * channels), g(n * channels), h(n * channels);
+	for (int y = y0; y < y1; ++y)
+	{
+		const Scalar *row = reinterpret_cast<const Scalar *>(src[y]);
+		for (int i = 0; i < n; ++i)
+		{
+			int x = std::min(std::max(i + shift, 0), cols - 1);
+			for (int c = 0; c < channels; ++c)
+				padded[i * channels + c] = row[x * channels + c];
+		}
+		van_herk_line(&padded[0], n, channels, length, &g[0], &h[0],
+			dst + (y - y0) * dst_step, op);
+	}
+}
+
+
+/*
+	Rectangular erosion (MorphologyMin) or dilation (MorphologyMax).
+*/
+template<class T, class Op>
+void morphology(const MatrixWrapper<T> input, MatrixWrapper<T> output,
+	int radius_x, int radius_y, Op op, int threads)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	const int channels = int(sizeof(T) / sizeof(Scalar));
+
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	assert(radius_x >= 0 && radius_y >= 0);
+	if (input.rows() == 0 || input.cols() == 0)
+		return;
+
+	const int rows = input.rows(), count = input.cols() * channels;
+	std::vector<Scalar> buffer(size_t(rows) * count);
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		morphology_rows(input, &buffer[size_t(y0) * count], count, input.cols(),
+			-radius_x, 2 * radius_x + 1, y0, y1, op);
+	});
+
+	// vertical pass, streaming blocks of `length` rows: the output row
+	// kL + t is op(h of block k at t, g of block k + 1 at t - 1)
+	const int length = 2 * radius_y + 1;
+	parallel_for(0, count, threads, [&](int i0, int i1)
+	{
+		const int width = i1 - i0;
+		std::vector<Scalar> g(size_t(length) * width), h(size_t(length) * width);
+		auto source = [&](int padded_y) -> const Scalar *
+		{
+			int y = std::min(std::max(padded_y - radius_y, 0), rows - 1);
+			return &buffer[size_t(y) * count + i0];
+		};
+
+		// the suffix mins of block k, from the rows at [k*L, k*L + L)
+		auto suffix = [&](int k)
+		{
+			Scalar *last = &h[size_t(length - 1) * width];
+			const Scalar *s = source(k * length + length - 1);
+			std::copy(s, s + width, last);
+			for (int t = length - 2; t >= 0; --t)
+			{
+				Scalar *cur = &h[size_t(t) * width];
+				const Scalar *next = cur + width;
+				s = source(k * length + t);
+				for (int i = 0; i < width; ++i)
+					cur[i] = op(next[i], s[i]);
+			}
+		};
+
+		for (int k = 0; k * length < rows; ++k)
+		{
+			suffix(k);
+
+			// prefix mins of block k + 1, only as far as needed
+			int ts = std::min(length, rows - k * length);
+			const Scalar *s = source((k + 1) * length);
+			std::copy(s, s + width, &g[0]);
+			for (int t = 1; t < ts - 1; ++t)
+			{
+				Scalar *cur = &g[size_t(t) * width];
+				const Scalar *prev = cur - width;
+				s = source((k + 1) * length + t);
+				for (int i = 0; i < width; ++i)
+					cur[i] = op(prev[i], s[i]);
+			}
+
+			for (int t = 0; t < ts; ++t)
+			{
+				Scalar *dst = reinterpret_cast<Scalar *>(output[k * length + t]) + i0;
+				const Scalar *hs = &h[size_t(t) * width];
+				if (t == 0)
+				{
+					std::copy(hs, hs + width, dst);
+					continue;
+				}
+				const Scalar *gs = &g[size_t(t - 1) * width];
+				for (int i = 0; i < width; ++i)
+					dst[i] = op(hs[i], gs[i]);
+			}
+		}
+	});
+}
+
+
+/*
+	Erosion (MorphologyMin) or dilation (MorphologyMax) by an
+	arbitrary structuring element, decomposed into horizontal runs.
+*/
+template<class T, class E, class Op>
+void morphology(const MatrixWrapper<T> input, MatrixWrapper<T> output,
+	const MatrixWrapper<E> element, Op op, int threads)
+{
+	typedef typename std::remove_all_extents<T>::type Scalar;
+	const int channels = int(sizeof(T) / sizeof(Scalar));
+
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+	assert(element.rows() % 2 == 1 && element.cols() % 2 == 1);
+	if (input.rows() == 0 || input.cols() == 0)
+		return;
+
+	struct Run { int dy, dx, length; };
+	std::vector<Run> runs;
+	std::vector<int> lengths;
+	const int ry = element.rows() / 2, rx = element.cols() / 2;
+	for (int y = 0; y < element.rows(); ++y)
+	{
+		for (int x = 0; x < element.cols(); )
+		{
+			if (!element[y][x])
+			{
+				++x;
+				continue;
+			}
+			int x0 = x;
+			while (x < element.cols() && element[y][x])
+				++x;
+			Run run = { y - ry, x0 - rx, x - x0 };
+			runs.push_back(run);
+			if (std::find(lengths.begin(), lengths.end(), run.length) == lengths.end())
+				lengths.push_back(run.length);
+		}
+	}
+	assert(!runs.empty());
+
+	// one length at a time, the line pass over rows padded by rx on
+	// both sides: column j combines the source pixels [j - rx, j - rx + length).
+	// The runs of that length are folded into the result before the
+	// next length reuses the line buffer. The output is only written
+	// at the end, so it can be the input.
+	const int rows = input.rows(), cols = input.cols();
+	const int padded_cols = cols + 2 * rx;
+	const size_t step = size_t(padded_cols) * channels;
+	const int count = cols * channels;
+	std::vector<Scalar> line(rows * step), result(size_t(rows) * count);
+	for (size_t l = 0; l < lengths.size(); ++l)
+	{
+		parallel_for(0, rows, threads, [&](int y0, int y1)
+		{
+			morphology_rows(input, &line[y0 * step], step, padded_cols - lengths[l] + 1,
+				-rx, lengths[l], y0, y1, op);
+		});
+
+		parallel_for(0, rows, threads, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; ++y)
+			{
+				Scalar *r = &result[size_t(y) * count];
+				bool first = l == 0;
+				for (size_t k = 0; k < runs.size(); ++k)
+				{
+					if (runs[k].length != lengths[l])
+						continue;
+					int sy = std::min(std::max(y + runs[k].dy, 0), rows - 1);
+					const Scalar *s = &line[size_t(sy) * step + (runs[k].dx + rx) * channels];
+					if (first)
+						std::copy(s, s + count, r);
+					else
+						for (int i = 0; i < count; ++i)
+							r[i] = op(r[i], s[i]);
+					first = false;
+				}
+			}
+		});
+	}
+
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+			std::copy(&result[size_t(y) * count], &result[size_t(y) * count] + count,
+				reinterpret_cast<Scalar *>(output[y]));
+	});
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<T> input:
+		The input image, T is any scalar type, or an array of them for
+		multiple channels (processed independently).
+	MatrixWrapper<T> output:
+		The output image, with the same size. Can be the input itself.
+	int radius_x, int radius_y:
+		The structuring element is a (2*radius_x+1) x (2*radius_y+1)
+		rectangle.
+	or
+	const MatrixWrapper<E> element:
+		An arbitrary structuring element with odd sizes, centered,
+		nonzero elements are inside.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class T>
+void erode(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius_x, int radius_y,
+	int threads = 1)
+{
+	morphology(input, output, radius_x, radius_y, MorphologyMin(), threads);
+}
+
+
+template<class T>
+void dilate(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius_x, int radius_y,
+	int threads = 1)
+{
+	morphology(input, output, radius_x, radius_y, MorphologyMax(), threads);
+}
+
+
+template<class T, class E>
+void erode(const MatrixWrapper<T> input, MatrixWrapper<T> output, const MatrixWrapper<E> element,
+	int threads = 1)
+{
+	morphology(input, output, element, MorphologyMin(), threads);
+}
+
+
+template<class T, class E>
+void dilate(const MatrixWrapper<T> input, MatrixWrapper<T> output, const MatrixWrapper<E> element,
+	int threads = 1)
+{
+	morphology(input, output, element, MorphologyMax(), threads);
+}
+
+
+/*
+	Opening (erosion then dilation) and closing (dilation then
+	erosion), with the same arguments. Both steps use the element as
+	is, which is the exact opening and closing for symmetric elements.
+*/
+template<class T>
+void opening(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius_x, int radius_y,
+	int threads = 1)
+{
+	erode(input, output, radius_x, radius_y, threads);
+	dilate(output, output, radius_x, radius_y, threads);
+}
+
+
+template<class T>
+void closing(const MatrixWrapper<T> input, MatrixWrapper<T> output, int radius_x, int radius_y,
+	int threads = 1)
+{
+	dilate(input, output, radius_x, radius_y, threads);
+	erode(output, output, radius_x, radius_y, threads);
+}
+
+
+template<class T, class E>
+void opening(const MatrixWrapper<T> input, MatrixWrapper<T> output, const MatrixWrapper<E> element,
+	int threads = 1)
+{
+	erode(input, output, element, threads);
+	dilate(output, output, element, threads);
+}
+
+
+template<class T, class E>
+void closing(const MatrixWrapper<T> input, MatrixWrapper<T> output, const MatrixWrapper<E> element,
+	int threads = 1)
+{
+	dilate(input, output, element, threads);
+	erode(output, output, element, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_MORPHOLOGY_HPP
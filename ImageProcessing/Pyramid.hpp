@@ -0,0 +1,345 @@
+/*	================================================================
+	Gaussian and laplacian pyramids, after P.J. Burt and E.H. Adelson,
+	"The Laplacian Pyramid as a Compact Image Code", IEEE Trans.
+	Communications 31 (1983).
+
+	A Pyramid holds its levels in one allocation: level 0 on the left,
+	the smaller levels stacked on its right, so the whole pyramid takes
+	1.5 times the size of the image. Each level is a Matrix sharing
+	that memory. Level l+1 has ((rows+1)/2, (cols+1)/2) of level l.
+
+	pyramid_reduce blurs with the 5-tap kernel [1 4 6 4 1]/16 in both
+	directions and drops every other row and column. The two steps are
+	fused: only the kept rows are blurred vertically, one flat loop
+	over the row, and only the kept columns horizontally.
+
+	pyramid_expand doubles the size with the same kernel, split into
+	its even taps [1 6 1]/8 and odd taps [4 4]/8, so no zero is
+	inserted or multiplied.
+
+	The borders are replicated. The output rows are split among the
+	threads.
+
+	================================================================
+
+	Usage:
+
+		his::MatrixWrapper<float[3]> image_wrapper(image.data, image.rows, image.cols);
+		his::Pyramid<float[3]> bands(image.rows, image.cols, 6);
+		his::laplacian_pyramid(image_wrapper, bands, 0);
+		for (int l = 0; l < bands.levels(); ++l)
+			process(bands[l]);
+		his::collapse(bands, image_wrapper, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols*N/threads) per level, 4/3 of it for all
+	Space complexity: O(cols*N) floats per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_PYRAMID_HPP
+#define HIS_IMAGEPROCESSING_PYRAMID_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "Matrix.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+template<class T>
+class Pyramid
+{
+public:
+	Pyramid()
+	{}
+
+	/*
+		Inputs:
+		int rows, int cols: The size of level 0.
+		int levels:
+			The number of levels, at most until a level is 1 x 1.
+	*/
+	Pyramid(int rows, int cols, int levels)
+	{
+		create(rows, cols, levels);
+	}
+
+	void create(int rows, int cols, int levels)
+	{
+		assert(rows > 0 && cols > 0 && levels > 0);
+
+		std::vector<int> heights(1, rows), widths(1, cols);
+		while (int(heights.size()) < levels && (heights.back() > 1 || widths.back() > 1))
+		{
+			heights.push_back((heights.back() + 1) / 2);
+			widths.push_back((widths.back() + 1) / 2);
+		}
+
+		int stacked = 0;
+		for (size_t l = 1; l < heights.size(); ++l)
+			stacked += heights[l];
+		int side = heights.size() > 1 ? widths[1] : 0;
+		m_storage.create(std::max(rows, stacked), cols + side);
+
+		m_levels.assign(1, m_storage.crop(0, 0, rows, cols));
+		for (size_t l = 1, top = 0; l < heights.size(); top += heights[l++])
+			m_levels.push_back(m_storage.crop(int(top), cols, heights[l], widths[l]));
+	}
+
+	int levels() const { return int(m_levels.size()); }
+
+	Matrix<T> &operator[](int l) { return m_levels[l]; }
+	const Matrix<T> &operator[](int l) const { return m_levels[l]; }
+
+private:
+	Matrix<T> m_storage;
+	std::vector<Matrix<T>> m_levels;
+};
+
+
+// 5-tap reduce, store(y, row) receives the out_cols*N floats of output row y
+template<class Src, class StoreFunc>
+void pyramid_reduce_rows(const MatrixWrapper<Src> &input, int out_rows, int out_cols,
+	StoreFunc store, int threads)
+{
+	typedef typename std::remove_all_extents<Src>::type Scalar;
+	const int channels = int(sizeof(Src) / sizeof(Scalar));
+	const int rows = input.rows(), cols = input.cols();
+	const int count = cols * channels;
+	if (out_rows == 0 || out_cols == 0)
+		return;
+
+	parallel_for(0, out_rows, threads, [&](int y0, int y1)
+	{
+		// 2 replicated pixels on each side
+		std::vector<float> padded((cols + 4) * channels), row(out_cols * channels);
+		for (int y = y0; y < y1; ++y)
+		{
+			const Scalar *r[5];
+			for (int i = 0; i < 5; ++i)
+				r[i] = reinterpret_cast<const Scalar *>(input[std::min(std::max(2 * y + i - 2, 0), rows - 1)]);
+
+			float *p = &padded[2 * channels];
+			for (int i = 0; i < count; ++i)
+				p[i] = (float(r[0][i]) + float(r[4][i])) + 4 * (float(r[1][i]) + float(r[3][i]))
+					+ 6 * float(r[2][i]);
+			for (int i = 0; i < 2 * channels; ++i)
+			{
+				padded[i] = p[i % channels];
+				p[count + i] = p[count - channels + i % channels];
+			}
+
+			for (int x = 0; x < out_cols; ++x)
+			{
+				const float *q = &padded[2 * x * channels];
+				for (int c = 0; c < channels; ++c)
+					row[x * channels + c] = ((q[c] + q[4 * channels + c])
+						+ 4 * (q[channels + c] + q[3 * channels + c]) + 6 * q[2 * channels + c]) * (1 / 256.f);
+			}
+			store(y, &row[0]);
+		}
+	});
+}
+
+
+// polyphase expand, store(y, row) receives the out_cols*N floats of output row y
+template<class Src, class StoreFunc>
+void pyramid_expand_rows(const MatrixWrapper<Src> &input, int out_rows, int out_cols,
+	StoreFunc store, int threads)
+{
+	typedef typename std::remove_all_extents<Src>::type Scalar;
+	const int channels = int(sizeof(Src) / sizeof(Scalar));
+	const int rows = input.rows(), cols = input.cols();
+	const int count = cols * channels;
+	assert((out_rows + 1) / 2 == rows && (out_cols + 1) / 2 == cols);
+	if (out_rows == 0 || out_cols == 0)
+		return;
+
+	parallel_for(0, out_rows, threads, [&](int y0, int y1)
+	{
+		// 1 replicated pixel on each side
+		std::vector<float> padded((cols + 2) * channels), row(out_cols * channels);
+		for (int y = y0; y < y1; ++y)
+		{
+			const int m = y / 2;
+			const Scalar *r0 = reinterpret_cast<const Scalar *>(input[std::max(m - 1, 0)]);
+			const Scalar *r1 = reinterpret_cast<const Scalar *>(input[m]);
+			const Scalar *r2 = reinterpret_cast<const Scalar *>(input[std::min(m + 1, rows - 1)]);
+
+			float *p = &padded[channels];
+			if (y % 2 == 0)
+				for (int i = 0; i < count; ++i)
+					p[i] = (float(r0[i]) + float(r2[i]) + 6 * float(r1[i])) * (1 / 8.f);
+			else
+				for (int i = 0; i < count; ++i)
+					p[i] = (float(r1[i]) + float(r2[i])) * (4 / 8.f);
+			for (int i = 0; i < channels; ++i)
+			{
+				padded[i] = p[i];
+				p[count + i] = p[count - channels + i];
+			}
+
+			for (int x = 0; x < cols; ++x)
+			{
+				const float *q = &padded[x * channels];
+				float *even = &row[2 * x * channels];
+				for (int c = 0; c < channels; ++c)
+					even[c] = (q[c] + q[2 * channels + c] + 6 * q[channels + c]) * (1 / 8.f);
+				if (2 * x + 1 < out_cols)
+					for (int c = 0; c < channels; ++c)
+						even[channels + c] = (q[channels + c] + q[2 * channels + c]) * (4 / 8.f);
+			}
+			store(y, &row[0]);
+		}
+	});
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> input:
+		The input image, of any scalar type, or an array of them for
+		multiple channels.
+	MatrixWrapper<Dst> output:
+		The output image, ((rows+1)/2, (cols+1)/2) of the input, with the
+		same number of channels. Integer outputs are rounded and
+		saturated, see Convert.hpp.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void pyramid_reduce(const MatrixWrapper<Src> input, MatrixWrapper<Dst> output, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	const int count = output.cols() * int(sizeof(Dst) / sizeof(DstScalar));
+	assert(output.rows() == (input.rows() + 1) / 2 && output.cols() == (input.cols() + 1) / 2);
+
+	pyramid_reduce_rows(input, output.rows(), output.cols(), [&](int y, const float *row)
+	{
+		DstScalar *dst = reinterpret_cast<DstScalar *>(output[y]);
+		for (int i = 0; i < count; ++i)
+			dst[i] = saturate_cast<DstScalar>(row[i]);
+	}, threads);
+}
+
+
+/*
+	The inverse size change: the output has (2*rows, 2*cols) of the
+	input, or one less in either direction. See pyramid_reduce.
+*/
+template<class Src, class Dst>
+void pyramid_expand(const MatrixWrapper<Src> input, MatrixWrapper<Dst> output, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	const int count = output.cols() * int(sizeof(Dst) / sizeof(DstScalar));
+
+	pyramid_expand_rows(input, output.rows(), output.cols(), [&](int y, const float *row)
+	{
+		DstScalar *dst = reinterpret_cast<DstScalar *>(output[y]);
+		for (int i = 0; i < count; ++i)
+			dst[i] = saturate_cast<DstScalar>(row[i]);
+	}, threads);
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> image: The image.
+	Pyramid<Dst> &pyramid:
+		The output, created with the size of the image and the number
+		of levels. Level 0 is the image itself.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void gaussian_pyramid(const MatrixWrapper<Src> image, Pyramid<Dst> &pyramid, int threads = 1)
+{
+	assert(pyramid.levels() > 0);
+	assert(pyramid[0].rows() == image.rows() && pyramid[0].cols() == image.cols());
+
+	convert(image, MatrixWrapper<Dst>(pyramid[0]), 1, 0, threads);
+	for (int l = 1; l < pyramid.levels(); ++l)
+		pyramid_reduce(MatrixWrapper<Dst>(pyramid[l - 1]), MatrixWrapper<Dst>(pyramid[l]), threads);
+}
+
+
+/*
+	The laplacian pyramid: level l is the difference between the
+	gaussian levels l and the expanded l+1, the last level is the
+	last gaussian level. Dst should be a signed type, usually float.
+	See gaussian_pyramid.
+*/
+template<class Src, class Dst>
+void laplacian_pyramid(const MatrixWrapper<Src> image, Pyramid<Dst> &pyramid, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	const int channels = int(sizeof(Dst) / sizeof(DstScalar));
+
+	gaussian_pyramid(image, pyramid, threads);
+
+	// from level 0 up, so level l+1 is still gaussian when it is expanded
+	for (int l = 0; l + 1 < pyramid.levels(); ++l)
+	{
+		MatrixWrapper<Dst> level = pyramid[l];
+		const int count = level.cols() * channels;
+		pyramid_expand_rows(MatrixWrapper<Dst>(pyramid[l + 1]), level.rows(), level.cols(),
+			[&](int y, const float *row)
+		{
+			DstScalar *dst = reinterpret_cast<DstScalar *>(level[y]);
+			for (int i = 0; i < count; ++i)
+				dst[i] = saturate_cast<DstScalar>(float(dst[i]) - row[i]);
+		}, threads);
+	}
+}
+
+
+/*
+	Rebuild the image from a laplacian pyramid.
+
+	Inputs:
+	const Pyramid<Src> &laplacian: The pyramid, unchanged.
+	MatrixWrapper<Dst> output: The image, with the size of level 0.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void collapse(const Pyramid<Src> &laplacian, MatrixWrapper<Dst> output, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+	const int levels = laplacian.levels();
+	assert(levels > 0);
+	assert(laplacian[0].rows() == output.rows() && laplacian[0].cols() == output.cols());
+
+	// expand into a copy, from the top down
+	Pyramid<Src> work(laplacian[0].rows(), laplacian[0].cols(), levels);
+	convert(MatrixWrapper<Src>(laplacian[levels - 1]), MatrixWrapper<Src>(work[levels - 1]), 1, 0, threads);
+
+	for (int l = levels - 2; l >= 0; --l)
+	{
+		const MatrixWrapper<Src> band = laplacian[l];
+		MatrixWrapper<Src> level = work[l];
+		const int count = level.cols() * channels;
+		pyramid_expand_rows(MatrixWrapper<Src>(work[l + 1]), level.rows(), level.cols(),
+			[&](int y, const float *row)
+		{
+			const SrcScalar *b = reinterpret_cast<const SrcScalar *>(band[y]);
+			SrcScalar *dst = reinterpret_cast<SrcScalar *>(level[y]);
+			for (int i = 0; i < count; ++i)
+				dst[i] = saturate_cast<SrcScalar>(float(b[i]) + row[i]);
+		}, threads);
+	}
+
+	convert(MatrixWrapper<Src>(work[0]), output, 1, 0, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_PYRAMID_HPP
@@ -0,0 +1,240 @@
+/*	================================================================
+	A recursive (IIR) approximation of the gaussian blur, after
+	I.T. Young and L.J. van Vliet, "Recursive implementation of the
+	Gaussian filter", Signal Processing 44 (1995).
+
+	Every row, then every column, is filtered by a causal 3rd order
+	recursion followed by an anti-causal one:
+
+		w[n] = B*x[n] + (b1*w[n-1] + b2*w[n-2] + b3*w[n-3]) / b0
+		y[n] = B*w[n] + (b1*y[n+1] + b2*y[n+2] + b3*y[n+3]) / b0
+
+	The cost per pixel is constant, whatever sigma is, whereas the
+	kernel of gaussian_kernel grows with sigma. The approximation is
+	close to the sampled gaussian from sigma = 2 or so; for a smaller
+	sigma a small kernel is both cheaper and more exact. The borders
+	are handled as if the edge pixels were replicated, with the exact
+	initialization of Triggs and Sdika.
+
+	The horizontal pass runs rows in parallel. The vertical pass runs
+	the recursion over whole rows at once: each step is a flat loop
+	across the columns, which the compiler vectorizes, and the columns
+	are split among the threads.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::MatrixWrapper<uchar[3]> image_wrapper(image.data, image.rows, image.cols);
+		his::recursive_gaussian(image_wrapper, image_wrapper, 20.0, 0);
+
+	================================================================
+
+	Time complexity: O(rows*cols*N/threads), independent of sigma
+	Space complexity: rows*cols*N floats
+*/
+
+#ifndef HIS_IMAGEPROCESSING_RECURSIVEGAUSSIAN_HPP
+#define HIS_IMAGEPROCESSING_RECURSIVEGAUSSIAN_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "Matrix.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+/*
+	The normalized coefficients of the recursion:
+		out[n] = B*in[n] + a1*out[n-1] + a2*out[n-2] + a3*out[n-3]
+	with B + a1 + a2 + a3 = 1.
+
+	With replicated borders, the causal pass starts in the steady state
+	of the first value. The anti-causal pass starts from the exact state
+	given by B. Triggs and M. Sdika, "Boundary conditions for Young-van
+	Vliet recursive filtering", IEEE Trans. Signal Processing 54 (2006):
+		out[N-1+j] = last + B * sum_k(M[j][k] * (w[N-1-k] - last))
+	for j in [0, 3), where w is the causal output and last the last input.
+*/
+struct RecursiveGaussianCoefficients
+{
+	float B, a1, a2, a3;
+	float M[3][3];
+
+	explicit RecursiveGaussianCoefficients(double sigma)
+	{
+		assert(sigma >= 0.5);
+		double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330
+			: 3.97156 - 4.14554 * std::sqrt(1 - 0.26891 * sigma);
+		double q2 = q * q, q3 = q2 * q;
+		double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+		double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+		double b2 = -(1.4281 * q2 + 1.26661 * q3);
+		double b3 = 0.422205 * q3;
+
+		double c1 = b1 / b0, c2 = b2 / b0, c3 = b3 / b0;
+		a1 = float(c1), a2 = float(c2), a3 = float(c3);
+		B = float(1 - c1 - c2 - c3);
+
+		double scale = 1 / ((1 + c1 - c2 + c3) * (1 - c1 - c2 - c3) * (1 + c2 + (c1 - c3) * c3));
+		M[0][0] = float(scale * (-c3 * c1 + 1 - c3 * c3 - c2));
+		M[0][1] = float(scale * (c3 + c1) * (c2 + c3 * c1));
+		M[0][2] = float(scale * c3 * (c1 + c3 * c2));
+		M[1][0] = float(scale * (c1 + c3 * c2));
+		M[1][1] = float(-scale * (c2 - 1) * (c2 + c3 * c1));
+		M[1][2] = float(-scale * c3 * (c3 * c1 + c3 * c3 + c2 - 1));
+		M[2][0] = float(scale * (c3 * c1 + c2 + c1 * c1 - c2 * c2));
+		M[2][1] = float(scale * (c1 * c2 + c3 * c2 * c2 - c1 * c3 * c3 - c3 * c3 * c3 - c3 * c2 + c3));
+		M[2][2] = float(scale * c3 * (c1 + c3 * c2));
+	}
+
+	// the anti-causal state out[N-1+j], from the causal tail
+	float tail(int j, float last, float w0, float w1, float w2) const
+	{
+		return last + B * (M[j][0] * (w0 - last) + M[j][1] * (w1 - last) + M[j][2] * (w2 - last));
+	}
+};
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> input:
+		The input image, of any scalar type, or an array of them for
+		multiple channels.
+	MatrixWrapper<Dst> output:
+		The output image, with the same size and number of channels.
+		Can be the input itself. Integer outputs are rounded and
+		saturated, see Convert.hpp.
+	double sigma:
+		The standard deviation of the gaussian, at least 0.5.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void recursive_gaussian(const MatrixWrapper<Src> input, MatrixWrapper<Dst> output,
+	double sigma, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+	static_assert(sizeof(Src) / sizeof(SrcScalar) == sizeof(Dst) / sizeof(DstScalar),
+		"input and output must have the same number of channels");
+
+	assert(input.rows() == output.rows() && input.cols() == output.cols());
+
+	const int rows = input.rows(), cols = input.cols();
+	if (rows == 0 || cols == 0)
+		return;
+
+	const RecursiveGaussianCoefficients k(sigma);
+	const int count = cols * channels;
+	Matrix<float> buffer(rows, count);
+
+	// horizontal pass, row by row
+	parallel_for(0, rows, threads, [&](int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			const SrcScalar *src = reinterpret_cast<const SrcScalar *>(input[y]);
+			float *line = buffer[y];
+			for (int i = 0; i < count; ++i)
+				line[i] = float(src[i]);
+
+			for (int c = 0; c < channels; ++c)
+			{
+				float *p = line + c;
+				float last = p[(cols - 1) * channels];
+
+				// causal, from the steady state of the first value
+				float w1 = p[0], w2 = p[0], w3 = p[0];
+				for (int x = 0; x < cols; ++x)
+				{
+					float w = k.B * p[x * channels] + k.a1 * w1 + k.a2 * w2 + k.a3 * w3;
+					p[x * channels] = w;
+					w3 = w2, w2 = w1, w1 = w;
+				}
+
+				// anti-causal
+				float t0 = p[(cols - 1) * channels];
+				float t1 = p[std::max(cols - 2, 0) * channels];
+				float t2 = p[std::max(cols - 3, 0) * channels];
+				w1 = k.tail(0, last, t0, t1, t2);
+				w2 = k.tail(1, last, t0, t1, t2);
+				w3 = k.tail(2, last, t0, t1, t2);
+				p[(cols - 1) * channels] = w1;
+				for (int x = cols - 2; x >= 0; --x)
+				{
+					float w = k.B * p[x * channels] + k.a1 * w1 + k.a2 * w2 + k.a3 * w3;
+					p[x * channels] = w;
+					w3 = w2, w2 = w1, w1 = w;
+				}
+			}
+		}
+	});
+
+	// vertical pass, whole rows at once, the columns split among threads
+	parallel_for(0, count, threads, [&](int i0, int i1)
+	{
+		std::vector<float> last(buffer[rows - 1] + i0, buffer[rows - 1] + i1);
+
+		// causal, rows before the first one are in its steady state
+		for (int y = 1; y < rows; ++y)
+		{
+			float *w = buffer[y];
+			const float *w1 = buffer[y - 1];
+			const float *w2 = buffer[std::max(y - 2, 0)];
+			const float *w3 = buffer[std::max(y - 3, 0)];
+			for (int i = i0; i < i1; ++i)
+				w[i] = k.B * w[i] + k.a1 * w1[i] + k.a2 * w2[i] + k.a3 * w3[i];
+		}
+
+		// anti-causal, from the two virtual rows after the last one
+		std::vector<float> after1(i1 - i0), after2(i1 - i0);
+		{
+			float *t0 = buffer[rows - 1];
+			const float *t1 = buffer[std::max(rows - 2, 0)];
+			const float *t2 = buffer[std::max(rows - 3, 0)];
+			for (int i = i0; i < i1; ++i)
+			{
+				float l = last[i - i0];
+				after1[i - i0] = k.tail(1, l, t0[i], t1[i], t2[i]);
+				after2[i - i0] = k.tail(2, l, t0[i], t1[i], t2[i]);
+				t0[i] = k.tail(0, l, t0[i], t1[i], t2[i]);
+			}
+		}
+		auto row = [&](int y) -> const float *
+		{
+			if (y < rows)
+				return buffer[y] + i0;
+			return (y == rows ? &after1[0] : &after2[0]);
+		};
+		for (int y = rows - 2; y >= 0; --y)
+		{
+			float *w = buffer[y] + i0;
+			const float *w1 = row(y + 1), *w2 = row(y + 2), *w3 = row(y + 3);
+			for (int i = 0; i < i1 - i0; ++i)
+				w[i] = k.B * w[i] + k.a1 * w1[i] + k.a2 * w2[i] + k.a3 * w3[i];
+		}
+
+		for (int y = 0; y < rows; ++y)
+		{
+			const float *w = buffer[y];
+			DstScalar *dst = reinterpret_cast<DstScalar *>(output[y]);
+			for (int i = i0; i < i1; ++i)
+				dst[i] = saturate_cast<DstScalar>(w[i]);
+		}
+	});
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_RECURSIVEGAUSSIAN_HPP
@@ -0,0 +1,236 @@
+/*	================================================================
+	Reductions over matrices: sum, min/max, mean, argmin, etc.
+
+	reduce combines all elements of a matrix with a binary operation.
+	transform_reduce first maps the corresponding elements of 1 to 4
+	matrices to a value, then combines these values.
+
+	Inputs:
+		Mat1 mat1[, [Mat2 mat2, ... Mat4 mat4]]:
+			Matrices to iterate, including IdxMap.
+		T init:
+			The identity element of op (0 for +, +inf for min, ...).
+			Every partial accumulator starts from it.
+		ReduceFunc op:
+			A functor T(T, T), it must be associative and commutative.
+		TransformFunc transform:
+			A functor taking corresponding elements, returning a T.
+		int threads:
+			Number of threads, 0 for all cores. See Parallel.hpp.
+
+	Every thread reduces a band of rows, with a few independent
+	accumulators (lanes) interleaved along the row. The lanes break
+	the dependency chain of the accumulation, so the compiler can
+	keep them in registers and vectorize. The partial results are
+	combined as a balanced tree at the end. Since the order of the
+	combinations depends on the lanes and threads, op must be
+	commutative, as for std::reduce.
+
+	================================================================
+
+	Usage:
+
+		float sum = his::reduce(gray, 0.f, std::plus<float>());
+
+		typedef std::pair<float, his::Idx> Candidate;
+		Candidate darkest = his::transform_reduce(gray, his::IdxMap(gray),
+			Candidate(FLT_MAX, his::Idx()),
+			[](const Candidate &a, const Candidate &b)
+		{
+			// the smaller value, ties broken by position to stay commutative
+			if (a.first != b.first)
+				return a.first < b.first ? a : b;
+			return a.second.y < b.second.y || (a.second.y == b.second.y
+				&& a.second.x < b.second.x) ? a : b;
+		},
+			[](float v, his::Idx idx) { return Candidate(v, idx); }, 0);
+*/
+
+#ifndef HIS_IMAGEPROCESSING_REDUCE_HPP
+#define HIS_IMAGEPROCESSING_REDUCE_HPP
+
+#include <cassert>
+#include <vector>
+
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+// number of independent accumulators along a row
+const int reduce_lanes = 4;
+
+
+/*
+	The common part of the reductions: row_func(y, lanes) accumulates
+	row y into the reduce_lanes accumulators, rows are split among
+	threads, and all partial results are combined as a tree.
+*/
+template<class T, class ReduceFunc, class RowFunc>
+T reduce_rows(int rows, T init, ReduceFunc &op, RowFunc row_func, int threads)
+{
+	static_assert(reduce_lanes == 4, "lanes are initialized and combined by hand");
+
+	int chunks = thread_count(threads, rows);
+	std::vector<T> partials(chunks, init);
+
+	parallel_chunks(0, rows, chunks, [&](int chunk, int y0, int y1)
+	{
+		T lanes[reduce_lanes] = { init, init, init, init };
+		for (int y = y0; y < y1; ++y)
+			row_func(y, lanes);
+		partials[chunk] = op(op(lanes[0], lanes[1]), op(lanes[2], lanes[3]));
+	});
+
+	for (size_t width = 1; width < partials.size(); width *= 2)
+		for (size_t i = 0; i + width < partials.size(); i += 2 * width)
+			partials[i] = op(partials[i], partials[i + width]);
+	return partials[0];
+}
+
+
+template<class Mat1, class T, class ReduceFunc, class TransformFunc>
+T transform_reduce(Mat1 mat, T init, ReduceFunc op, TransformFunc transform, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+
+	return reduce_rows(mat.rows(), init, op, [&](int y, T *lanes)
+	{
+		auto p = mat[y];
+		int x = 0;
+		for (; x + reduce_lanes <= mat.cols(); x += reduce_lanes)
+		{
+			for (int l = 0; l < reduce_lanes; ++l)
+			{
+				lanes[l] = op(lanes[l], transform(*p));
+				p += 1;
+			}
+		}
+		for (; x < mat.cols(); ++x)
+		{
+			lanes[0] = op(lanes[0], transform(*p));
+			p += 1;
+		}
+	}, threads);
+}
+
+
+// 2 matrices
+template<class Mat1, class Mat2, class T, class ReduceFunc, class TransformFunc>
+T transform_reduce(Mat1 mat1, Mat2 mat2, T init, ReduceFunc op, TransformFunc transform, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+
+	return reduce_rows(mat1.rows(), init, op, [&](int y, T *lanes)
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		int x = 0;
+		for (; x + reduce_lanes <= mat1.cols(); x += reduce_lanes)
+		{
+			for (int l = 0; l < reduce_lanes; ++l)
+			{
+				lanes[l] = op(lanes[l], transform(*p1, *p2));
+				p1 += 1, p2 += 1;
+			}
+		}
+		for (; x < mat1.cols(); ++x)
+		{
+			lanes[0] = op(lanes[0], transform(*p1, *p2));
+			p1 += 1, p2 += 1;
+		}
+	}, threads);
+}
+
+
+// 3 matrices
+template<class Mat1, class Mat2, class Mat3, class T, class ReduceFunc, class TransformFunc>
+T transform_reduce(Mat1 mat1, Mat2 mat2, Mat3 mat3, T init, ReduceFunc op, TransformFunc transform,
+	int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+
+	return reduce_rows(mat1.rows(), init, op, [&](int y, T *lanes)
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		auto p3 = mat3[y];
+		int x = 0;
+		for (; x + reduce_lanes <= mat1.cols(); x += reduce_lanes)
+		{
+			for (int l = 0; l < reduce_lanes; ++l)
+			{
+				lanes[l] = op(lanes[l], transform(*p1, *p2, *p3));
+				p1 += 1, p2 += 1, p3 += 1;
+			}
+		}
+		for (; x < mat1.cols(); ++x)
+		{
+			lanes[0] = op(lanes[0], transform(*p1, *p2, *p3));
+			p1 += 1, p2 += 1, p3 += 1;
+		}
+	}, threads);
+}
+
+
+// 4 matrices
+template<class Mat1, class Mat2, class Mat3, class Mat4, class T, class ReduceFunc, class TransformFunc>
+T transform_reduce(Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, T init, ReduceFunc op,
+	TransformFunc transform, int threads = 1)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+    assert(Mat4::FOR_EACH_ABLE == Mat4::FOR_EACH_ABLE);
+
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+	assert(mat1.rows() == mat4.rows() && mat1.cols() == mat4.cols());
+
+	return reduce_rows(mat1.rows(), init, op, [&](int y, T *lanes)
+	{
+		auto p1 = mat1[y];
+		auto p2 = mat2[y];
+		auto p3 = mat3[y];
+		auto p4 = mat4[y];
+		int x = 0;
+		for (; x + reduce_lanes <= mat1.cols(); x += reduce_lanes)
+		{
+			for (int l = 0; l < reduce_lanes; ++l)
+			{
+				lanes[l] = op(lanes[l], transform(*p1, *p2, *p3, *p4));
+				p1 += 1, p2 += 1, p3 += 1, p4 += 1;
+			}
+		}
+		for (; x < mat1.cols(); ++x)
+		{
+			lanes[0] = op(lanes[0], transform(*p1, *p2, *p3, *p4));
+			p1 += 1, p2 += 1, p3 += 1, p4 += 1;
+		}
+	}, threads);
+}
+
+
+/*
+	Reduce the elements of a matrix directly, they must be convertible
+	to T.
+*/
+template<class Mat1, class T, class ReduceFunc>
+T reduce(Mat1 mat, T init, ReduceFunc op, int threads = 1)
+{
+	typedef decltype(*mat[0]) Element;
+	return transform_reduce(mat, init, op, [](Element e) -> T { return e; }, threads);
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_REDUCE_HPP
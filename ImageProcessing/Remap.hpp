@@ -0,0 +1,292 @@
+/*	================================================================
+	Geometric transforms: remap samples the source at arbitrary
+	coordinates given by two maps, resize scales the whole image.
+	Both support nearest, bilinear and bicubic interpolation (the
+	cubic convolution of R. Keys, a = -0.5).
+
+	Coordinates are in source pixels, pixel centers at integers, and
+	samples outside of the source are replicated from the border.
+
+	remap walks the destination by tiles of remap_tile x remap_tile
+	pixels. The source rows read by a tile of a smooth warp stay few
+	and in cache, unlike a walk along whole destination rows, which
+	sweeps the source once per row for a rotation. The tiles are
+	split among the threads.
+
+	resize is separable. The source positions, clamped indices and
+	weights of every destination column and row are computed once
+	into tables. Each destination row first blends its 1, 2 or 4
+	source rows, one flat loop over the row which the compiler
+	vectorizes, then picks the columns through the table. The rows are
+	split among the threads.
+
+	The filters do not widen with the scale, so a strong downsizing
+	aliases. Halve the image with pyramid_reduce first.
+
+	================================================================
+
+	Usage:
+
+		typedef unsigned char uchar;
+
+		his::MatrixWrapper<uchar[3]> src_wrapper(src.data, src.rows, src.cols);
+		his::MatrixWrapper<uchar[3]> dst_wrapper(dst.data, dst.rows, dst.cols);
+		his::resize(src_wrapper, dst_wrapper, his::INTERPOLATION_BICUBIC, 0);
+
+		// undistortion, with maps computed once
+		his::remap(src_wrapper, dst_wrapper, map_x, map_y, his::INTERPOLATION_BILINEAR, 0);
+
+	================================================================
+
+	Time complexity: O(dst_rows*dst_cols*N*K/threads), K taps per pixel
+	Space complexity:
+		remap: none
+		resize: O(dst_rows + dst_cols) table entries, O(src_cols*N)
+		floats per thread
+*/
+
+#ifndef HIS_IMAGEPROCESSING_REMAP_HPP
+#define HIS_IMAGEPROCESSING_REMAP_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "Convert.hpp"
+#include "MatrixWrapper.hpp"
+#include "../Miscellaneous/Parallel.hpp"
+
+namespace his
+{
+
+
+enum Interpolation
+{
+	INTERPOLATION_NEAREST,
+	INTERPOLATION_BILINEAR,
+	INTERPOLATION_BICUBIC
+};
+
+
+// destination tile size of remap, in pixels
+const int remap_tile = 32;
+
+
+/*
+	Output:
+		The number of taps of an interpolation, and for a position t on
+		an axis of `size` source pixels, the first source index and the
+		weights of the taps.
+
+	t is first clamped to [-2, size + 1]: beyond, every tap is
+	replicated from the border anyway, and the conversion to int of a
+	huge or NaN t is undefined. NaN reads the first pixel.
+*/
+inline int interpolation_taps(Interpolation interp)
+{
+	return interp == INTERPOLATION_NEAREST ? 1 : (interp == INTERPOLATION_BILINEAR ? 2 : 4);
+}
+
+inline int interpolation_weights(Interpolation interp, float t, int size, float *weights)
+{
+	if (!(t >= -2))
+		t = -2;
+	else if (t > float(size + 1))
+		t = float(size + 1);
+
+	if (interp == INTERPOLATION_NEAREST)
+	{
+		weights[0] = 1;
+		return int(std::floor(t + 0.5f));
+	}
+
+	int i = int(std::floor(t));
+	float f = t - i;
+	if (interp == INTERPOLATION_BILINEAR)
+	{
+		weights[0] = 1 - f;
+		weights[1] = f;
+		return i;
+	}
+
+	// Keys, a = -0.5, the taps at i-1, i, i+1, i+2
+	const float a = -0.5f;
+	weights[0] = ((a * (f + 1) - 5 * a) * (f + 1) + 8 * a) * (f + 1) - 4 * a;
+	weights[1] = ((a + 2) * f - (a + 3)) * f * f + 1;
+	weights[2] = ((a + 2) * (1 - f) - (a + 3)) * (1 - f) * (1 - f) + 1;
+	weights[3] = 1 - weights[0] - weights[1] - weights[2];
+	return i - 1;
+}
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> src:
+		The source image, of any scalar type, or an array of them for
+		multiple channels.
+	MatrixWrapper<Dst> dst:
+		The destination image, with the same number of channels. Must
+		not be the source. Integer outputs are rounded and saturated,
+		see Convert.hpp.
+	const MatrixWrapper<float> map_x, const MatrixWrapper<float> map_y:
+		The source coordinates of every destination pixel, with the
+		size of the destination. Coordinates outside of the source,
+		infinite or NaN read the border, see interpolation_weights.
+	Interpolation interp: The interpolation.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void remap(const MatrixWrapper<Src> src, MatrixWrapper<Dst> dst,
+	const MatrixWrapper<float> map_x, const MatrixWrapper<float> map_y,
+	Interpolation interp = INTERPOLATION_BILINEAR, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	static_assert(sizeof(Src) / sizeof(SrcScalar) == sizeof(Dst) / sizeof(DstScalar),
+		"source and destination must have the same number of channels");
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+
+	assert(map_x.rows() == dst.rows() && map_x.cols() == dst.cols());
+	assert(map_y.rows() == dst.rows() && map_y.cols() == dst.cols());
+
+	const int rows = src.rows(), cols = src.cols();
+	const int taps = interpolation_taps(interp);
+	const int tiles_y = (dst.rows() + remap_tile - 1) / remap_tile;
+	const int tiles_x = (dst.cols() + remap_tile - 1) / remap_tile;
+
+	parallel_for(0, tiles_y * tiles_x, threads, [&](int t0, int t1)
+	{
+		float wx[4], wy[4];
+		std::vector<float> sum(channels);
+		for (int t = t0; t < t1; ++t)
+		{
+			const int y0 = t / tiles_x * remap_tile, y1 = std::min(y0 + remap_tile, dst.rows());
+			const int x0 = t % tiles_x * remap_tile, x1 = std::min(x0 + remap_tile, dst.cols());
+
+			for (int y = y0; y < y1; ++y)
+			{
+				const float *mx = map_x[y], *my = map_y[y];
+				DstScalar *d = reinterpret_cast<DstScalar *>(dst[y]);
+				for (int x = x0; x < x1; ++x)
+				{
+					int sx = interpolation_weights(interp, mx[x], cols, wx);
+					int sy = interpolation_weights(interp, my[x], rows, wy);
+
+					std::fill(sum.begin(), sum.end(), 0.f);
+					for (int i = 0; i < taps; ++i)
+					{
+						const SrcScalar *s = reinterpret_cast<const SrcScalar *>(
+							src[std::min(std::max(sy + i, 0), rows - 1)]);
+						for (int j = 0; j < taps; ++j)
+						{
+							const SrcScalar *p = s + std::min(std::max(sx + j, 0), cols - 1) * channels;
+							const float w = wy[i] * wx[j];
+							for (int c = 0; c < channels; ++c)
+								sum[c] += w * float(p[c]);
+						}
+					}
+					for (int c = 0; c < channels; ++c)
+						d[x * channels + c] = saturate_cast<DstScalar>(sum[c]);
+				}
+			}
+		}
+	});
+}
+
+
+/*
+	The separable coefficient table of one axis of resize: for every
+	destination index, `taps` clamped source indices and weights.
+*/
+struct ResizeTable
+{
+	int taps;
+	std::vector<int> index;
+	std::vector<float> weight;
+
+	ResizeTable(int src_size, int dst_size, Interpolation interp)
+		: taps(interpolation_taps(interp)), index(dst_size * taps), weight(dst_size * taps)
+	{
+		const double scale = double(src_size) / dst_size;
+		for (int i = 0; i < dst_size; ++i)
+		{
+			// pixel centers of both images are aligned
+			float t = float((i + 0.5) * scale - 0.5);
+			int first = interpolation_weights(interp, t, src_size, &weight[i * taps]);
+			for (int k = 0; k < taps; ++k)
+				index[i * taps + k] = std::min(std::max(first + k, 0), src_size - 1);
+		}
+	}
+};
+
+
+/*
+	Inputs:
+	const MatrixWrapper<Src> src:
+		The source image, of any scalar type, or an array of them for
+		multiple channels.
+	MatrixWrapper<Dst> dst:
+		The destination image, of any size, with the same number of
+		channels. Must not be the source. Integer outputs are rounded
+		and saturated, see Convert.hpp.
+	Interpolation interp: The interpolation.
+	int threads:
+		Number of threads, 0 for all cores. See Parallel.hpp.
+*/
+template<class Src, class Dst>
+void resize(const MatrixWrapper<Src> src, MatrixWrapper<Dst> dst,
+	Interpolation interp = INTERPOLATION_BILINEAR, int threads = 1)
+{
+	typedef typename std::remove_all_extents<Src>::type SrcScalar;
+	typedef typename std::remove_all_extents<Dst>::type DstScalar;
+	static_assert(sizeof(Src) / sizeof(SrcScalar) == sizeof(Dst) / sizeof(DstScalar),
+		"source and destination must have the same number of channels");
+	const int channels = int(sizeof(Src) / sizeof(SrcScalar));
+
+	const ResizeTable table_x(src.cols(), dst.cols(), interp);
+	const ResizeTable table_y(src.rows(), dst.rows(), interp);
+	const int taps = table_x.taps, count = src.cols() * channels;
+
+	parallel_for(0, dst.rows(), threads, [&](int y0, int y1)
+	{
+		std::vector<float> row(count);
+		for (int y = y0; y < y1; ++y)
+		{
+			// vertical blend of the source rows
+			const int *iy = &table_y.index[y * taps];
+			const float *wy = &table_y.weight[y * taps];
+			const SrcScalar *s = reinterpret_cast<const SrcScalar *>(src[iy[0]]);
+			for (int i = 0; i < count; ++i)
+				row[i] = wy[0] * float(s[i]);
+			for (int k = 1; k < taps; ++k)
+			{
+				s = reinterpret_cast<const SrcScalar *>(src[iy[k]]);
+				const float w = wy[k];
+				for (int i = 0; i < count; ++i)
+					row[i] += w * float(s[i]);
+			}
+
+			// horizontal, through the table
+			DstScalar *d = reinterpret_cast<DstScalar *>(dst[y]);
+			for (int x = 0; x < dst.cols(); ++x)
+			{
+				const int *ix = &table_x.index[x * taps];
+				const float *wx = &table_x.weight[x * taps];
+				for (int c = 0; c < channels; ++c)
+				{
+					float sum = 0;
+					for (int k = 0; k < taps; ++k)
+						sum += wx[k] * row[ix[k] * channels + c];
+					d[x * channels + c] = saturate_cast<DstScalar>(sum);
+				}
+			}
+		}
+	});
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_REMAP_HPP
@@ -0,0 +1,454 @@
+/*	================================================================
+	A run-length encoded mask, and for_each/for_each_pair overloads
+	that only visit the pixels inside of it.
+
+	Each row of the mask is stored as a list of runs [x0, x1) of
+	inside pixels. Iterating a small region of interest on a large
+	image then skips the outside pixels entirely, instead of testing
+	every one of them in the functor.
+
+	Usage:
+
+		his::RunLengthMask roi(mask_wrapper);	// nonzero is inside
+
+		his::for_each(roi, image, [](uchar rgb[3])
+		{
+			// only called for pixels inside the mask
+		});
+
+		his::for_each_pair(roi, image, laplacian,
+			[](uchar b1, uchar b2, float &f1, float &f2)
+		{
+			// called for neighboring pixels with at least one of them
+			// inside the mask, including the pairs crossing the border
+		});
+
+	The mask is passed as the first argument, followed by the same
+	matrices and functor as the ordinary for_each/for_each_pair.
+*/
+
+#ifndef HIS_IMAGEPROCESSING_RUNLENGTHMASK_HPP
+#define HIS_IMAGEPROCESSING_RUNLENGTHMASK_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace his
+{
+
+
+class RunLengthMask
+{
+public:
+	/*
+		A horizontal run of inside pixels [x0, x1).
+	*/
+	struct Run
+	{
+		int x0, x1;
+	};
+
+	RunLengthMask() : m_rows(0), m_cols(0), m_row_start(1, 0)
+	{}
+
+	/*
+		Input:
+			const Mat mask: Any FOR_EACH_ABLE matrix, nonzero elements are inside.
+	*/
+	template<class Mat>
+	explicit RunLengthMask(const Mat mask)
+	{
+		typedef decltype(*mask[0]) Element;
+		build(mask, [](Element m) { return m != 0; });
+	}
+
+	/*
+		Inputs:
+			const Mat mask: Any FOR_EACH_ABLE matrix.
+			InsideFunc inside:
+				A functor taking an element of mask, returning true
+				if the pixel is inside.
+	*/
+	template<class Mat, class InsideFunc>
+	RunLengthMask(const Mat mask, InsideFunc inside)
+	{
+		build(mask, inside);
+	}
+
+	int rows() const { return m_rows; }
+	int cols() const { return m_cols; }
+
+	// the runs of row y are [begin(y), end(y))
+	const Run *begin(int y) const { return m_runs.data() + m_row_start[y]; }
+	const Run *end(int y) const { return m_runs.data() + m_row_start[y + 1]; }
+
+	/*
+		Output:
+			Number of inside pixels.
+	*/
+	size_t area() const
+	{
+		size_t area = 0;
+		for (auto &run : m_runs)
+			area += run.x1 - run.x0;
+		return area;
+	}
+
+private:
+	template<class Mat, class InsideFunc>
+	void build(Mat mask, InsideFunc inside)
+	{
+	    assert(Mat::FOR_EACH_ABLE == Mat::FOR_EACH_ABLE);
+
+		m_rows = mask.rows(), m_cols = mask.cols();
+		m_row_start.assign(1, 0);
+		for (int y = 0; y < m_rows; ++y)
+		{
+			auto p = mask[y];
+			int x = 0;
+			while (x < m_cols)
+			{
+				while (x < m_cols && !inside(*(p + x)))
+					++x;
+				Run run = { x, x };
+				while (x < m_cols && inside(*(p + x)))
+					++x;
+				run.x1 = x;
+				if (run.x1 > run.x0)
+					m_runs.push_back(run);
+			}
+			m_row_start.push_back(m_runs.size());
+		}
+	}
+
+	int m_rows, m_cols;
+	std::vector<Run> m_runs;
+	std::vector<size_t> m_row_start;
+};
+
+
+/*
+	Visit the segments of pixel pairs touching the mask, row by row.
+	vertical(y, x0, x1): pairs (x, y-1)-(x, y) for x in [x0, x1)
+	horizontal(y, x0, x1): pairs (x-1, y)-(x, y) for x in [x0, x1)
+*/
+template<class VerticalFunc, class HorizontalFunc>
+void for_each_run_pair(const RunLengthMask &mask, VerticalFunc vertical, HorizontalFunc horizontal)
+{
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		// union of the runs of rows y-1 and y
+		if (y > 0)
+		{
+			const RunLengthMask::Run *a = mask.begin(y - 1), *a_end = mask.end(y - 1);
+			const RunLengthMask::Run *b = mask.begin(y), *b_end = mask.end(y);
+			while (a != a_end || b != b_end)
+			{
+				const RunLengthMask::Run *next =
+					(b == b_end || (a != a_end && a->x0 < b->x0)) ? a++ : b++;
+				int x0 = next->x0, x1 = next->x1;
+				while (true)
+				{
+					if (a != a_end && a->x0 <= x1)
+						x1 = std::max(x1, (a++)->x1);
+					else if (b != b_end && b->x0 <= x1)
+						x1 = std::max(x1, (b++)->x1);
+					else
+						break;
+				}
+				vertical(y, x0, x1);
+			}
+		}
+
+		// pairs with the left neighbor, the run extended by one pixel on the right
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+		{
+			int x0 = std::max(run->x0, 1);
+			int x1 = std::min(run->x1 + 1, mask.cols());
+			if (x1 > x0)
+				horizontal(y, x0, x1);
+		}
+	}
+}
+
+
+template<class Mat1, class Func>
+void for_each(const RunLengthMask &mask, Mat1 mat, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat.rows() && mask.cols() == mat.cols());
+
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+		{
+			auto p = mat[y] + run->x0;
+			for (int x = run->x0; x < run->x1; ++x)
+			{
+				func(*p);
+				p += 1;
+			}
+		}
+	}
+}
+
+
+// 2 matrices
+template<class Mat1, class Mat2, class Func>
+void for_each(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+		{
+			auto p1 = mat1[y] + run->x0;
+			auto p2 = mat2[y] + run->x0;
+			for (int x = run->x0; x < run->x1; ++x)
+			{
+				func(*p1, *p2);
+				p1 += 1, p2 += 1;
+			}
+		}
+	}
+}
+
+
+// 3 matrices
+template<class Mat1, class Mat2, class Mat3, class Func>
+void for_each(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Mat3 mat3, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+		{
+			auto p1 = mat1[y] + run->x0;
+			auto p2 = mat2[y] + run->x0;
+			auto p3 = mat3[y] + run->x0;
+			for (int x = run->x0; x < run->x1; ++x)
+			{
+				func(*p1, *p2, *p3);
+				p1 += 1, p2 += 1, p3 += 1;
+			}
+		}
+	}
+}
+
+
+// 4 matrices
+template<class Mat1, class Mat2, class Mat3, class Mat4, class Func>
+void for_each(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+    assert(Mat4::FOR_EACH_ABLE == Mat4::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+	assert(mat1.rows() == mat4.rows() && mat1.cols() == mat4.cols());
+
+	for (int y = 0; y < mask.rows(); ++y)
+	{
+		for (const RunLengthMask::Run *run = mask.begin(y); run != mask.end(y); ++run)
+		{
+			auto p1 = mat1[y] + run->x0;
+			auto p2 = mat2[y] + run->x0;
+			auto p3 = mat3[y] + run->x0;
+			auto p4 = mat4[y] + run->x0;
+			for (int x = run->x0; x < run->x1; ++x)
+			{
+				func(*p1, *p2, *p3, *p4);
+				p1 += 1, p2 += 1, p3 += 1, p4 += 1;
+			}
+		}
+	}
+}
+
+
+template<class Mat1, class Func>
+void for_each_pair(const RunLengthMask &mask, Mat1 mat, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat.rows() && mask.cols() == mat.cols());
+
+	for_each_run_pair(mask, [&](int y, int x0, int x1)
+	{
+		auto up = mat[y - 1] + x0;
+		auto down = mat[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*up, *down);
+			up += 1, down += 1;
+		}
+	},
+		[&](int y, int x0, int x1)
+	{
+		auto left = mat[y] + (x0 - 1);
+		auto right = mat[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*left, *right);
+			left += 1, right += 1;
+		}
+	});
+}
+
+
+template<class Mat1, class Mat2, class Func>
+void for_each_pair(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+
+	for_each_run_pair(mask, [&](int y, int x0, int x1)
+	{
+		auto up1 = mat1[y - 1] + x0;
+		auto down1 = mat1[y] + x0;
+		auto up2 = mat2[y - 1] + x0;
+		auto down2 = mat2[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*up1, *down1, *up2, *down2);
+			up1 += 1, down1 += 1;
+			up2 += 1, down2 += 1;
+		}
+	},
+		[&](int y, int x0, int x1)
+	{
+		auto left1 = mat1[y] + (x0 - 1);
+		auto right1 = mat1[y] + x0;
+		auto left2 = mat2[y] + (x0 - 1);
+		auto right2 = mat2[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*left1, *right1, *left2, *right2);
+			left1 += 1, right1 += 1;
+			left2 += 1, right2 += 1;
+		}
+	});
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class Func>
+void for_each_pair(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Mat3 mat3, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+
+	for_each_run_pair(mask, [&](int y, int x0, int x1)
+	{
+		auto up1 = mat1[y - 1] + x0;
+		auto down1 = mat1[y] + x0;
+		auto up2 = mat2[y - 1] + x0;
+		auto down2 = mat2[y] + x0;
+		auto up3 = mat3[y - 1] + x0;
+		auto down3 = mat3[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*up1, *down1, *up2, *down2, *up3, *down3);
+			up1 += 1, down1 += 1;
+			up2 += 1, down2 += 1;
+			up3 += 1, down3 += 1;
+		}
+	},
+		[&](int y, int x0, int x1)
+	{
+		auto left1 = mat1[y] + (x0 - 1);
+		auto right1 = mat1[y] + x0;
+		auto left2 = mat2[y] + (x0 - 1);
+		auto right2 = mat2[y] + x0;
+		auto left3 = mat3[y] + (x0 - 1);
+		auto right3 = mat3[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*left1, *right1, *left2, *right2, *left3, *right3);
+			left1 += 1, right1 += 1;
+			left2 += 1, right2 += 1;
+			left3 += 1, right3 += 1;
+		}
+	});
+}
+
+
+template<class Mat1, class Mat2, class Mat3, class Mat4, class Func>
+void for_each_pair(const RunLengthMask &mask, Mat1 mat1, Mat2 mat2, Mat3 mat3, Mat4 mat4, Func func)
+{
+    assert(Mat1::FOR_EACH_ABLE == Mat1::FOR_EACH_ABLE);
+    assert(Mat2::FOR_EACH_ABLE == Mat2::FOR_EACH_ABLE);
+    assert(Mat3::FOR_EACH_ABLE == Mat3::FOR_EACH_ABLE);
+    assert(Mat4::FOR_EACH_ABLE == Mat4::FOR_EACH_ABLE);
+
+	assert(mask.rows() == mat1.rows() && mask.cols() == mat1.cols());
+	assert(mat1.rows() == mat2.rows() && mat1.cols() == mat2.cols());
+	assert(mat1.rows() == mat3.rows() && mat1.cols() == mat3.cols());
+	assert(mat1.rows() == mat4.rows() && mat1.cols() == mat4.cols());
+
+	for_each_run_pair(mask, [&](int y, int x0, int x1)
+	{
+		auto up1 = mat1[y - 1] + x0;
+		auto down1 = mat1[y] + x0;
+		auto up2 = mat2[y - 1] + x0;
+		auto down2 = mat2[y] + x0;
+		auto up3 = mat3[y - 1] + x0;
+		auto down3 = mat3[y] + x0;
+		auto up4 = mat4[y - 1] + x0;
+		auto down4 = mat4[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*up1, *down1, *up2, *down2, *up3, *down3, *up4, *down4);
+			up1 += 1, down1 += 1;
+			up2 += 1, down2 += 1;
+			up3 += 1, down3 += 1;
+			up4 += 1, down4 += 1;
+		}
+	},
+		[&](int y, int x0, int x1)
+	{
+		auto left1 = mat1[y] + (x0 - 1);
+		auto right1 = mat1[y] + x0;
+		auto left2 = mat2[y] + (x0 - 1);
+		auto right2 = mat2[y] + x0;
+		auto left3 = mat3[y] + (x0 - 1);
+		auto right3 = mat3[y] + x0;
+		auto left4 = mat4[y] + (x0 - 1);
+		auto right4 = mat4[y] + x0;
+		for (int x = x0; x < x1; ++x)
+		{
+			func(*left1, *right1, *left2, *right2, *left3, *right3, *left4, *right4);
+			left1 += 1, right1 += 1;
+			left2 += 1, right2 += 1;
+			left3 += 1, right3 += 1;
+			left4 += 1, right4 += 1;
+		}
+	});
+}
+
+
+}
+#endif // HIS_IMAGEPROCESSING_RUNLENGTHMASK_HPP
@@ -0,0 +1,145 @@
+/*	========================================================================
+	A self-contained radix-2 fast Fourier transform, in 1d and 2d, over
+	std::complex<float>.
+
+	Usage:
+		his::FFT fft(256);				// the size must be a power of 2
+		std::vector<std::complex<float>> data(256);
+		fft.forward(&data[0]);
+		fft.inverse(&data[0]);			// data is back, times 256
+
+		his::FFT2D fft2d(64);			// 64 x 64, row-major
+		fft2d.forward(&tile[0]);
+
+	Neither direction is normalized, a forward then inverse transform
+	multiplies the data by the number of elements.
+
+	The twiddle factors and the bit reversal permutation are computed
+	once in the constructor, so a plan is meant to be reused. The
+	transforms only read the plan, they can run concurrently on
+	different data.
+
+	Time complexity: O(n log n)
+	========================================================================
+*/
+
+#ifndef HIS_MISCELLANEOUS_FFT_HPP
+#define HIS_MISCELLANEOUS_FFT_HPP
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+
+namespace his
+{
+
+
+class FFT
+{
+public:
+	typedef std::complex<float> Complex;
+
+	explicit FFT(int size)
+		: m_size(size), m_twiddle(size / 2), m_reverse(size)
+	{
+		assert(size > 0 && (size & (size - 1)) == 0);
+
+		const double pi = 3.14159265358979323846;
+		for (int i = 0; i < size / 2; ++i)
+			m_twiddle[i] = Complex(float(std::cos(-2 * pi * i / size)),
+				float(std::sin(-2 * pi * i / size)));
+
+		int bits = 0;
+		while ((1 << bits) < size)
+			++bits;
+		for (int i = 0; i < size; ++i)
+		{
+			int r = 0;
+			for (int b = 0; b < bits; ++b)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			m_reverse[i] = r;
+		}
+	}
+
+	int size() const { return m_size; }
+
+	void forward(Complex *data) const { transform(data, false); }
+	void inverse(Complex *data) const { transform(data, true); }
+
+private:
+	void transform(Complex *data, bool inverse) const
+	{
+		for (int i = 0; i < m_size; ++i)
+			if (i < m_reverse[i])
+				std::swap(data[i], data[m_reverse[i]]);
+
+		for (int half = 1; half < m_size; half *= 2)
+		{
+			// twiddles of this stage are every step-th of the full table
+			int step = m_size / (2 * half);
+			for (int start = 0; start < m_size; start += 2 * half)
+			{
+				for (int k = 0; k < half; ++k)
+				{
+					Complex w = m_twiddle[k * step];
+					if (inverse)
+						w = std::conj(w);
+					Complex &a = data[start + k], &b = data[start + k + half];
+					Complex t(w.real() * b.real() - w.imag() * b.imag(),
+						w.real() * b.imag() + w.imag() * b.real());
+					b = a - t;
+					a += t;
+				}
+			}
+		}
+	}
+
+	int m_size;
+	std::vector<Complex> m_twiddle;
+	std::vector<int> m_reverse;
+};
+
+
+/*
+	A square size x size 2d transform over row-major data: the rows,
+	then the columns.
+*/
+class FFT2D
+{
+public:
+	typedef FFT::Complex Complex;
+
+	explicit FFT2D(int size) : m_fft(size)
+	{}
+
+	int size() const { return m_fft.size(); }
+
+	void forward(Complex *data) const { transform(data, false); }
+	void inverse(Complex *data) const { transform(data, true); }
+
+private:
+	void transform(Complex *data, bool inverse) const
+	{
+		const int n = m_fft.size();
+		for (int y = 0; y < n; ++y)
+			inverse ? m_fft.inverse(data + y * n) : m_fft.forward(data + y * n);
+
+		std::vector<Complex> column(n);
+		for (int x = 0; x < n; ++x)
+		{
+			for (int y = 0; y < n; ++y)
+				column[y] = data[y * n + x];
+			inverse ? m_fft.inverse(&column[0]) : m_fft.forward(&column[0]);
+			for (int y = 0; y < n; ++y)
+				data[y * n + x] = column[y];
+		}
+	}
+
+	FFT m_fft;
+};
+
+
+}
+#endif // HIS_MISCELLANEOUS_FFT_HPP
@@ -0,0 +1,117 @@
+/*	========================================================================
+	A minimal fork-join utility on top of std::thread, shared by the
+	data structures and image processing functions that offer a
+	parallel mode.
+
+	Usage:
+		his::parallel_for(0, rows, threads, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; ++y)
+				process_row(y);
+		});
+
+	The range [begin, end) is split into contiguous chunks, one chunk
+	per thread, and the call returns when all of them are done. The
+	calling thread processes the first chunk itself.
+
+	Convention:
+		Functions with a parallel mode take a trailing `int threads`
+		argument. It defaults to 1 (run in the calling thread), and 0
+		means one thread per hardware core.
+		Functors given to such functions may be called concurrently
+		when threads != 1.
+
+	========================================================================
+*/
+
+#ifndef HIS_MISCELLANEOUS_PARALLEL_HPP
+#define HIS_MISCELLANEOUS_PARALLEL_HPP
+
+#include <thread>
+#include <vector>
+
+namespace his
+{
+
+
+/*
+	Output:
+		Number of hardware threads, at least 1.
+*/
+inline int hardware_threads()
+{
+	int threads = static_cast<int>(std::thread::hardware_concurrency());
+	return threads > 0 ? threads : 1;
+}
+
+
+/*
+	Inputs:
+		int threads: Requested number of threads, 0 for all cores.
+		size_t work: Number of work items to split.
+	Output:
+		Number of threads actually worth starting, in [1, work].
+*/
+inline int thread_count(int threads, size_t work)
+{
+	if (threads <= 0)
+		threads = hardware_threads();
+	if (static_cast<size_t>(threads) > work)
+		threads = static_cast<int>(work);
+	return threads > 0 ? threads : 1;
+}
+
+
+/*
+	Split [begin, end) into exactly `chunks` contiguous pieces (some may
+	be empty) and run func(chunk, chunk_begin, chunk_end) on each piece
+	in its own thread.
+	The chunk id is in [0, chunks), useful to address per-thread partial
+	results.
+*/
+template<typename Int, class Func>
+void parallel_chunks(Int begin, Int end, int chunks, Func func)
+{
+	if (chunks <= 1)
+	{
+		func(0, begin, end);
+		return;
+	}
+
+	Int size = end > begin ? end - begin : 0;
+	auto bound = [&](int chunk) -> Int
+	{
+		return begin + static_cast<Int>(size / chunks * chunk
+			+ size % chunks * chunk / chunks);
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunks - 1);
+	for (int chunk = 1; chunk < chunks; ++chunk)
+	{
+		Int b = bound(chunk), e = bound(chunk + 1);
+		workers.push_back(std::thread([=]() { func(chunk, b, e); }));
+	}
+
+	func(0, begin, bound(1));
+
+	for (auto &worker : workers)
+		worker.join();
+}
+
+
+/*
+	Run func(chunk_begin, chunk_end) over [begin, end) with the given
+	number of threads (see the convention above).
+*/
+template<typename Int, class Func>
+void parallel_for(Int begin, Int end, int threads, Func func)
+{
+	size_t size = end > begin ? static_cast<size_t>(end - begin) : 0;
+	parallel_chunks(begin, end, thread_count(threads, size),
+		[&](int, Int b, Int e) { func(b, e); });
+}
+
+
+}
+#endif // HIS_MISCELLANEOUS_PARALLEL_HPP
@@ -0,0 +1,110 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+using namespace std;
+
+#include "his/ImageProcessing/BilateralGrid.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	The brute-force bilateral filter in double, with gaussian weights in
+	space and range over a window of 3 sigma_space, and the pixels
+	outside of the image left out.
+*/
+template<int N>
+his::Matrix<float[N]> ReferenceBilateral(const his::Matrix<float[N]> &input,
+	const his::Matrix<float> &guide, double sigma_space, double sigma_range)
+{
+	const int rows = input.rows(), cols = input.cols(), radius = int(ceil(3 * sigma_space));
+	his::Matrix<float[N]> output(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			double sum[N] = {}, sum_w = 0;
+			for (int sy = max(y - radius, 0); sy <= min(y + radius, rows - 1); ++sy)
+				for (int sx = max(x - radius, 0); sx <= min(x + radius, cols - 1); ++sx)
+				{
+					double ds = ((sx - x) * (sx - x) + (sy - y) * (sy - y)) / (sigma_space * sigma_space);
+					double dr = (guide[sy][sx] - guide[y][x]) / sigma_range;
+					double w = exp(-0.5 * (ds + dr * dr));
+					for (int c = 0; c < N; ++c)
+						sum[c] += w * input[sy][sx][c];
+					sum_w += w;
+				}
+			for (int c = 0; c < N; ++c)
+				output[y][x][c] = float(sum[c] / sum_w);
+		}
+	return output;
+}
+
+/*
+	A smooth guide, a ramp with a slow wave over a few sigma_range, and
+	an input that follows it with noise on top. The grid and the
+	reference are compared by their mean and largest absolute errors,
+	in gray levels, away from the borders where the grid lacks the
+	neighbors the reference leaves out.
+*/
+template<int N>
+void TestBilateralGrid(int rows, int cols, double sigma_space, double sigma_range,
+	float max_mean, float max_error, int threads)
+{
+	his::Matrix<float> guide(rows, cols);
+	his::Matrix<float[N]> input(rows, cols), output(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			guide[y][x] = float(160.0 * (x + y) / (rows + cols) + 40 * sin(x * 0.05) * cos(y * 0.07));
+			for (int c = 0; c < N; ++c)
+				input[y][x][c] = guide[y][x] + float(rand() % 41 - 20) + 10 * c;
+		}
+
+	his::Matrix<float[N]> expected = ReferenceBilateral(input, guide, sigma_space, sigma_range);
+	his::bilateral_grid(his::MatrixWrapper<float[N]>(input), his::MatrixWrapper<float>(guide),
+		his::MatrixWrapper<float[N]>(output), sigma_space, sigma_range, threads);
+
+	const int margin = int(2 * sigma_space);
+	double mean = 0, error = 0;
+	int count = 0;
+	for (int y = margin; y < rows - margin; ++y)
+		for (int x = margin; x < cols - margin; ++x)
+			for (int c = 0; c < N; ++c)
+			{
+				double e = fabs(output[y][x][c] - expected[y][x][c]);
+				mean += e, error = max(error, e), ++count;
+			}
+	mean /= count;
+	if (mean > max_mean || error > max_error)
+		printf("Error %dx%d, sigmas %g, %g, %d threads: mean error %f, largest %f\n",
+			rows, cols, sigma_space, sigma_range, threads, mean, error);
+}
+
+/*
+	Empty images are left alone, in both overloads.
+*/
+void TestEmpty(int rows, int cols)
+{
+	his::Matrix<unsigned char> input(rows, cols), output(rows, cols);
+	his::Matrix<float> guide(rows, cols);
+	his::bilateral_grid(his::MatrixWrapper<unsigned char>(input), his::MatrixWrapper<float>(guide),
+		his::MatrixWrapper<unsigned char>(output), 4.0, 10.0, 3);
+	his::bilateral_grid(his::MatrixWrapper<unsigned char>(input),
+		his::MatrixWrapper<unsigned char>(output), 4.0, 10.0, 3);
+}
+
+int main()
+{
+	TestEmpty(0, 0);
+	TestEmpty(0, 17);
+	TestEmpty(17, 0);
+
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestBilateralGrid<1>(61, 67, 4, 20, 0.8f, 2.6f, threads[t]);
+		TestBilateralGrid<3>(53, 79, 8, 30, 0.9f, 2.4f, threads[t]);
+		TestBilateralGrid<1>(47, 45, 2, 15, 1.2f, 4.f, threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "his/DataStructure/BinaryIndexedTree.hpp"
+#include "his/DataStructure/ConcurrentBinaryIndexedTree.hpp"
+
+/*
+	Use BinaryIndexedTree as a dynamic cumulative histogram.
+	Counts are updated one at a time, and prefix sums are compared
+	with a brute force summation.
+*/
+void TestCumulativeHistogram(size_t test_size)
+{
+	vector<int> counts(test_size);
+	for (size_t i = 0; i < counts.size(); ++i)
+		counts[i] = rand() % 100;
+
+	// O(N) build from the initial counts, keys are 1-based
+	his::BinaryIndexedTree<size_t, int> tree(begin(counts), end(counts));
+
+	for (size_t n = 0; n < test_size; ++n)
+	{
+		size_t key = rand() % test_size + 1;
+		tree.Add(key, 1);
+		counts[key - 1] += 1;
+
+		int prefix = 0;
+		for (size_t i = 0; i < key; ++i)
+			prefix += counts[i];
+		if (tree.Accumulate(key) != prefix || tree.Get(key) != counts[key - 1])
+			printf("Error %zu\n", key);
+	}
+}
+
+/*
+	Weighted sampling with LowerBound: draw a uniform number in
+	[1, total], the key whose prefix sum first reaches it is drawn
+	with probability proportional to its weight.
+*/
+void TestWeightedSampling(size_t test_size)
+{
+	vector<int> weights(test_size);
+	for (size_t i = 0; i < weights.size(); ++i)
+		weights[i] = rand() % 10;
+
+	his::BinaryIndexedTree<size_t, int> tree(begin(weights), end(weights));
+	int total = tree.Accumulate(test_size);
+
+	for (size_t n = 0; n < test_size; ++n)
+	{
+		int target = rand() % total + 1;
+		size_t key = tree.LowerBound(target);
+		if (tree.Accumulate(key) < target || tree.Accumulate(key - 1) >= target)
+			printf("Error %d\n", target);
+	}
+}
+
+/*
+	Add a value to ranges of keys, and query range sums.
+*/
+void TestRangeUpdate(size_t test_size)
+{
+	vector<long long> values(test_size, 0);
+	his::RangeBinaryIndexedTree<size_t, long long> tree(test_size);
+
+	for (size_t n = 0; n < test_size; ++n)
+	{
+		size_t first = rand() % test_size + 1, last = rand() % test_size + 1;
+		if (first > last)
+			swap(first, last);
+
+		long long val = rand() % 100;
+		tree.RangeAdd(first, last, val);
+		for (size_t i = first; i <= last; ++i)
+			values[i - 1] += val;
+
+		long long sum = 0;
+		for (size_t i = first; i <= last; ++i)
+			sum += values[i - 1];
+		if (tree.RangeSum(first, last) != sum)
+			printf("Error [%zu %zu]\n", first, last);
+	}
+}
+
+/*
+	Many threads counting into the same cumulative histogram.
+	A plain BinaryIndexedTree behind a mutex is compared with the
+	ConcurrentBinaryIndexedTree, through its atomic Add and through one
+	buffered Writer per thread, for an increasing number of threads.
+	The final prefix sums must match the total number of additions.
+*/
+void BenchmarkConcurrentHistogram(size_t bins, size_t additions)
+{
+	typedef his::ConcurrentBinaryIndexedTree<size_t, long long> Histogram;
+
+	auto elapsed_ms = [](chrono::steady_clock::time_point start)->double
+	{
+		return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	};
+
+	// run count(t) in each of the threads
+	auto run = [&](int threads, function<void(int)> count)->double
+	{
+		auto start = chrono::steady_clock::now();
+		vector<thread> workers;
+		for (int t = 0; t < threads; ++t)
+			workers.push_back(thread(count, t));
+		for (auto &worker : workers)
+			worker.join();
+		return elapsed_ms(start);
+	};
+
+	int max_threads = 2 * max(1, (int)thread::hardware_concurrency());
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		size_t per_thread = additions / threads;
+
+		his::BinaryIndexedTree<size_t, long long> locked_tree(bins);
+		mutex lock;
+		double locked_ms = run(threads, [&](int t)
+		{
+			minstd_rand random(t);
+			for (size_t n = 0; n < per_thread; ++n)
+			{
+				size_t key = random() % bins + 1;
+				lock_guard<mutex> guard(lock);
+				locked_tree.Add(key, 1);
+			}
+		});
+
+		Histogram atomic_tree(bins);
+		double atomic_ms = run(threads, [&](int t)
+		{
+			minstd_rand random(t);
+			for (size_t n = 0; n < per_thread; ++n)
+				atomic_tree.Add(random() % bins + 1, 1);
+		});
+
+		Histogram buffered_tree(bins);
+		double buffered_ms = run(threads, [&](int t)
+		{
+			minstd_rand random(t);
+			Histogram::Writer writer(buffered_tree);
+			for (size_t n = 0; n < per_thread; ++n)
+				writer.Add(random() % bins + 1, 1);
+		});
+
+		long long total = (long long)(per_thread * threads);
+		if (locked_tree.Accumulate(bins) != total || atomic_tree.Accumulate(bins) != total
+			|| buffered_tree.Accumulate(bins) != total)
+			printf("Error %d threads\n", threads);
+		for (size_t key = 1; key <= bins; key += bins / 64)
+		{
+			if (buffered_tree.Accumulate(key) != locked_tree.Accumulate(key)
+				|| atomic_tree.Accumulate(key) != locked_tree.Accumulate(key))
+				printf("Error %d threads, key %zu\n", threads, key);
+		}
+
+		printf("%2d threads: mutex %8.1f ms, atomic %8.1f ms, writers %8.1f ms\n",
+			threads, locked_ms, atomic_ms, buffered_ms);
+	}
+}
+
+int main()
+{
+	TestCumulativeHistogram(1000);
+	TestWeightedSampling(1000);
+	TestRangeUpdate(1000);
+	BenchmarkConcurrentHistogram(1 << 16, 1 << 22);
+
+	return 0;
+}
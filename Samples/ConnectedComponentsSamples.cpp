@@ -0,0 +1,137 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/ConnectedComponents.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	A brute-force reference: a flood fill from every unlabeled pixel in
+	raster order, so the labels follow the first pixels as well.
+*/
+vector<his::Component> FloodFill(const his::MatrixWrapper<unsigned char> input,
+	his::MatrixWrapper<int> labels, int connectivity)
+{
+	vector<his::Component> components;
+	for (int y = 0; y < input.rows(); ++y)
+		for (int x = 0; x < input.cols(); ++x)
+			labels[y][x] = -1;
+
+	for (int y = 0; y < input.rows(); ++y)
+	{
+		for (int x = 0; x < input.cols(); ++x)
+		{
+			if (labels[y][x] >= 0)
+				continue;
+
+			his::Component c = { 0, x, y, x, y, 0.0, 0.0 };
+			int label = int(components.size());
+			vector<pair<int, int>> stack(1, make_pair(x, y));
+			labels[y][x] = label;
+			while (!stack.empty())
+			{
+				int px = stack.back().first, py = stack.back().second;
+				stack.pop_back();
+
+				++c.area;
+				c.left = min(c.left, px), c.right = max(c.right, px);
+				c.top = min(c.top, py), c.bottom = max(c.bottom, py);
+				c.x += px, c.y += py;
+
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int qx = px + dx, qy = py + dy;
+						if ((dx == 0 && dy == 0) || (connectivity == 4 && dx != 0 && dy != 0))
+							continue;
+						if (qx < 0 || qy < 0 || qx >= input.cols() || qy >= input.rows())
+							continue;
+						if (labels[qy][qx] < 0 && input[qy][qx] == input[py][px])
+						{
+							labels[qy][qx] = label;
+							stack.push_back(make_pair(qx, qy));
+						}
+					}
+				}
+			}
+			c.x /= c.area, c.y /= c.area;
+			components.push_back(c);
+		}
+	}
+	return components;
+}
+
+/*
+	Random images of a few values, from many small components to a
+	few large ones crossing all the strips, labeled with the given
+	threads and compared with the flood fill: every label, then area,
+	bounding box and centroid of every component.
+*/
+void TestConnectedComponents(int rows, int cols, int values, int connectivity, int threads)
+{
+	his::Matrix<unsigned char> input(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			input[y][x] = (unsigned char)(rand() % values);
+
+	his::Matrix<int> expected_labels(rows, cols), labels(rows, cols);
+	vector<his::Component> expected = FloodFill(input, expected_labels, connectivity);
+	vector<his::Component> components = his::connected_components(
+		his::MatrixWrapper<unsigned char>(input), labels, connectivity, threads);
+
+	if (components.size() != expected.size())
+	{
+		printf("Error %dx%d, %d values, %d-connectivity, %d threads: %zu components, expected %zu\n",
+			rows, cols, values, connectivity, threads, components.size(), expected.size());
+		return;
+	}
+
+	for (int y = 0; y < rows; ++y)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			if (labels[y][x] != expected_labels[y][x])
+			{
+				printf("Error %dx%d, %d-connectivity, %d threads: label %d at (%d, %d), expected %d\n",
+					rows, cols, connectivity, threads, labels[y][x], x, y, expected_labels[y][x]);
+				return;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		const his::Component &c = components[i], &e = expected[i];
+		if (c.area != e.area || c.left != e.left || c.top != e.top
+			|| c.right != e.right || c.bottom != e.bottom
+			|| fabs(c.x - e.x) > 1e-9 || fabs(c.y - e.y) > 1e-9)
+		{
+			printf("Error %dx%d, %d-connectivity, %d threads: component %zu has area %d, expected %d\n",
+				rows, cols, connectivity, threads, i, c.area, e.area);
+			return;
+		}
+	}
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3, 8 };
+	for (int t = 0; t < 4; ++t)
+	{
+		for (int connectivity = 4; connectivity <= 8; connectivity += 4)
+		{
+			TestConnectedComponents(1, 1, 2, connectivity, threads[t]);
+			TestConnectedComponents(1, 300, 2, connectivity, threads[t]);
+			TestConnectedComponents(300, 1, 2, connectivity, threads[t]);
+			TestConnectedComponents(5, 7, 1, connectivity, threads[t]);
+			TestConnectedComponents(97, 131, 2, connectivity, threads[t]);
+			TestConnectedComponents(97, 131, 3, connectivity, threads[t]);
+			TestConnectedComponents(200, 50, 16, connectivity, threads[t]);
+		}
+	}
+	return 0;
+}
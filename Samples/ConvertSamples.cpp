@@ -0,0 +1,135 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <limits>
+using namespace std;
+
+#include "his/ImageProcessing/Convert.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	A slow reference: clamp and round in long double, where halves are
+	exact for every float and double input of the tests.
+*/
+template<class Dst>
+Dst ReferenceCast(long double v)
+{
+	const long double lo = (long double)(numeric_limits<Dst>::min());
+	const long double hi = (long double)(numeric_limits<Dst>::max());
+	if (!(v >= lo))
+		return numeric_limits<Dst>::min();
+	if (v >= hi)
+		return numeric_limits<Dst>::max();
+	return Dst(roundl(v));
+}
+
+template<class Dst, class Src>
+void CheckCast(Src v, Dst expected, const char *type)
+{
+	Dst result = his::saturate_cast<Dst>(v);
+	if (result != expected)
+		printf("Error saturate_cast<%s>(%.17g) = %lld, expected %lld\n", type, double(v),
+			(long long)result, (long long)expected);
+}
+
+/*
+	Values next to the halves, where adding 0.5 in the source type
+	rounds up, and values next to the limits of 64-bit integers, which
+	are not doubles.
+*/
+void TestSaturateCastEdges()
+{
+	const float below_half_f = nextafterf(0.5f, 0.f);
+	const double below_half = nextafter(0.5, 0.);
+
+	CheckCast<unsigned char>(below_half_f, (unsigned char)0, "uchar");
+	CheckCast<short>(-below_half_f, (short)0, "short");
+	CheckCast<int>(below_half_f, 0, "int");
+	CheckCast<int>(below_half, 0, "int");
+	CheckCast<int>(-below_half, 0, "int");
+	CheckCast<long long>(below_half, 0LL, "long long");
+	CheckCast<int>(0.5f, 1, "int");
+	CheckCast<int>(-0.5, -1, "int");
+	CheckCast<int>(2.5, 3, "int");
+	CheckCast<short>(-2.5f, (short)-3, "short");
+	CheckCast<unsigned char>(254.5f, (unsigned char)255, "uchar");
+	CheckCast<unsigned char>(255.5f, (unsigned char)255, "uchar");
+	CheckCast<unsigned char>(-0.7f, (unsigned char)0, "uchar");
+	CheckCast<int>(8388609.f, 8388609, "int");
+
+	// out of range, infinite and NaN
+	CheckCast<unsigned char>(NAN, (unsigned char)0, "uchar");
+	CheckCast<int>(-INFINITY, INT32_MIN, "int");
+	CheckCast<int>(1e20f, INT32_MAX, "int");
+	CheckCast<int>(2147483647.4, INT32_MAX, "int");
+	CheckCast<int>(-2147483648.6, INT32_MIN, "int");
+
+	// 64-bit integers, their maximum rounds up to 2^63 (2^64) as a double
+	CheckCast<long long>(9223372036854774784.0, INT64_MAX - 1023, "long long");
+	CheckCast<long long>(9223372036854775807.0, INT64_MAX, "long long");
+	CheckCast<long long>(1e19, INT64_MAX, "long long");
+	CheckCast<long long>(1e300, INT64_MAX, "long long");
+	CheckCast<long long>(INFINITY, INT64_MAX, "long long");
+	CheckCast<long long>(-1e30f, INT64_MIN, "long long");
+	CheckCast<long long>(-9223372036854775808.0, INT64_MIN, "long long");
+	CheckCast<long long>(NAN, INT64_MIN, "long long");
+	CheckCast<unsigned long long>(1.8446744073709552e19, UINT64_MAX, "unsigned long long");
+	CheckCast<unsigned long long>(1e30f, UINT64_MAX, "unsigned long long");
+	CheckCast<unsigned long long>(-1.0, 0ULL, "unsigned long long");
+	CheckCast<long long>(4503599627370497.0, 4503599627370497LL, "long long");
+}
+
+/*
+	Random values in and around the range of each type, through
+	saturate_cast and convert, compared with the reference.
+*/
+template<class Dst, class Src>
+void TestConvert(double range, const char *type)
+{
+	const int rows = 31, cols = 47;
+	his::Matrix<Src> src(rows, cols);
+	his::Matrix<Dst> dst(rows, cols);
+	for (int y = 0; y < rows; ++y)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			// many exact halves, the rest anywhere
+			double v = (rand() % 2 ? (rand() % 2001 - 1000) * 0.5 : double(rand()) / RAND_MAX - 0.5);
+			src[y][x] = Src(v * range / 500);
+		}
+	}
+
+	for (int threads = 0; threads <= 3; threads += 3)
+	{
+		his::convert(his::MatrixWrapper<Src>(src), his::MatrixWrapper<Dst>(dst), 1, 0, threads);
+		for (int y = 0; y < rows; ++y)
+		{
+			for (int x = 0; x < cols; ++x)
+			{
+				Dst expected = ReferenceCast<Dst>(src[y][x]);
+				if (dst[y][x] != expected || his::saturate_cast<Dst>(src[y][x]) != expected)
+				{
+					printf("Error convert to %s: %.17g became %lld, expected %lld\n", type,
+						double(src[y][x]), (long long)dst[y][x], (long long)expected);
+					return;
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	TestSaturateCastEdges();
+	TestConvert<unsigned char, float>(300, "uchar");
+	TestConvert<unsigned char, double>(300, "uchar");
+	TestConvert<short, float>(40000, "short");
+	TestConvert<unsigned short, double>(70000, "ushort");
+	TestConvert<int, float>(3e9, "int");
+	TestConvert<int, double>(3e9, "int");
+	TestConvert<int, float>(10, "int");
+	TestConvert<long long, double>(1e19, "long long");
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Convolution.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+float Random()
+{
+	return float(rand()) / RAND_MAX * 2 - 1;
+}
+
+/*
+	The brute-force convolution in double: the kernel flipped, the
+	borders replicated.
+*/
+his::Matrix<float> ReferenceConvolution(const his::Matrix<float> &input, const his::Matrix<float> &kernel)
+{
+	const int ry = kernel.rows() / 2, rx = kernel.cols() / 2;
+	his::Matrix<float> output(input.rows(), input.cols());
+	for (int y = 0; y < input.rows(); ++y)
+		for (int x = 0; x < input.cols(); ++x)
+		{
+			double sum = 0;
+			for (int ky = 0; ky < kernel.rows(); ++ky)
+				for (int kx = 0; kx < kernel.cols(); ++kx)
+				{
+					int sy = min(max(y + ry - ky, 0), input.rows() - 1);
+					int sx = min(max(x + rx - kx, 0), input.cols() - 1);
+					sum += double(kernel[ky][kx]) * input[sy][sx];
+				}
+			output[y][x] = float(sum);
+		}
+	return output;
+}
+
+/*
+	A random image convolved by every method the kernel allows, each
+	compared with the reference. The tolerance is relative to the
+	largest possible output, sum(|kernel|) * max(|input|).
+*/
+void TestConvolution(int rows, int cols, const his::Matrix<float> &weights, const char *name)
+{
+	his::Matrix<float> input(rows, cols), output(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			input[y][x] = Random() * 100;
+
+	his::Matrix<float> expected = ReferenceConvolution(input, weights);
+	double scale = 0;
+	for (int y = 0; y < weights.rows(); ++y)
+		for (int x = 0; x < weights.cols(); ++x)
+			scale += fabs(weights[y][x]) * 100;
+	const double tolerance = 2e-5 * scale;
+
+	his::ConvolutionKernel kernel(weights);
+	const his::ConvolutionMethod methods[] =
+	{
+		his::CONVOLUTION_AUTO, his::CONVOLUTION_DIRECT, his::CONVOLUTION_SEPARABLE, his::CONVOLUTION_FFT
+	};
+	const char *method_names[] = { "auto", "direct", "separable", "fft" };
+	const int threads[] = { 1, 0, 3 };
+	for (int m = 0; m < 4; ++m)
+	{
+		if (methods[m] == his::CONVOLUTION_SEPARABLE && !kernel.separable())
+			continue;
+		for (int t = 0; t < 3; ++t)
+		{
+			his::convolve(his::MatrixWrapper<float>(input), his::MatrixWrapper<float>(output),
+				kernel, methods[m], threads[t]);
+			double error = 0;
+			for (int y = 0; y < rows; ++y)
+				for (int x = 0; x < cols; ++x)
+					error = max(error, fabs(double(output[y][x]) - expected[y][x]));
+			if (error > tolerance)
+				printf("Error %s over %dx%d, %s, %d threads: error %g, over %g\n",
+					name, rows, cols, method_names[m], threads[t], error, tolerance);
+		}
+	}
+}
+
+his::Matrix<float> SeparableKernel(int rows, int cols)
+{
+	vector<float> column(rows), row(cols);
+	for (int y = 0; y < rows; ++y)
+		column[y] = Random();
+	for (int x = 0; x < cols; ++x)
+		row[x] = Random();
+	his::Matrix<float> kernel(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			kernel[y][x] = column[y] * row[x];
+	return kernel;
+}
+
+his::Matrix<float> DenseKernel(int rows, int cols)
+{
+	his::Matrix<float> kernel(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			kernel[y][x] = Random();
+	return kernel;
+}
+
+/*
+	Empty images are left alone, by every method.
+*/
+void TestEmpty(int rows, int cols)
+{
+	his::Matrix<float> input(rows, cols), output(rows, cols);
+	his::ConvolutionKernel kernel(SeparableKernel(5, 3));
+	for (int m = his::CONVOLUTION_AUTO; m <= his::CONVOLUTION_FFT; ++m)
+		his::convolve(his::MatrixWrapper<float>(input), his::MatrixWrapper<float>(output),
+			kernel, his::ConvolutionMethod(m), 3);
+}
+
+int main()
+{
+	TestEmpty(0, 0);
+	TestEmpty(0, 17);
+	TestEmpty(17, 0);
+
+	// odd image and kernel sizes, kernels that are not symmetric, so a
+	// missing flip or a shifted tile shows
+	TestConvolution(37, 53, SeparableKernel(1, 1), "separable 1x1");
+	TestConvolution(37, 53, SeparableKernel(3, 5), "separable 3x5");
+	TestConvolution(101, 99, SeparableKernel(15, 15), "separable 15x15");
+	TestConvolution(61, 127, SeparableKernel(31, 9), "separable 31x9");
+	TestConvolution(9, 7, SeparableKernel(5, 3), "separable 5x3");
+	TestConvolution(37, 53, DenseKernel(7, 3), "dense 7x3");
+	TestConvolution(101, 99, DenseKernel(21, 17), "dense 21x17");
+	TestConvolution(23, 19, DenseKernel(33, 35), "dense 33x35");
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+#include "his/ImageProcessing/DistanceTransform.hpp"
+#include "his/ImageProcessing/IdxMap.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	The brute-force squared distance of every pixel to every feature,
+	-1 for a mask without features.
+*/
+his::Matrix<long long> ReferenceDistance(const his::Matrix<unsigned char> &mask)
+{
+	const int rows = mask.rows(), cols = mask.cols();
+	his::Matrix<long long> squared(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			long long best = -1;
+			for (int fy = 0; fy < rows; ++fy)
+				for (int fx = 0; fx < cols; ++fx)
+				{
+					if (!mask[fy][fx])
+						continue;
+					long long d = (long long)(fx - x) * (fx - x) + (long long)(fy - y) * (fy - y);
+					if (best < 0 || d < best)
+						best = d;
+				}
+			squared[y][x] = best;
+		}
+	return squared;
+}
+
+/*
+	Both overloads over a mask, the distances compared with the
+	reference, as floats and as saturated bytes. Any feature at the
+	smallest distance is a valid nearest one, so the Idx output is
+	checked to be a feature, at the expected distance.
+*/
+void TestDistanceTransform(const his::Matrix<unsigned char> &mask, const char *name, int threads)
+{
+	const int rows = mask.rows(), cols = mask.cols();
+	his::Matrix<long long> expected = ReferenceDistance(mask);
+
+	his::Matrix<float> distance(rows, cols), with_nearest(rows, cols);
+	his::Matrix<unsigned char> bytes(rows, cols);
+	his::Matrix<his::Idx> nearest(rows, cols);
+	his::MatrixWrapper<unsigned char> m(mask);
+	his::distance_transform(m, his::MatrixWrapper<float>(distance), threads);
+	his::distance_transform(m, his::MatrixWrapper<unsigned char>(bytes), threads);
+	his::distance_transform(m, his::MatrixWrapper<float>(with_nearest),
+		his::MatrixWrapper<his::Idx>(nearest), threads);
+
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			const long long e = expected[y][x];
+			const float d = e < 0 ? numeric_limits<float>::infinity() : float(e);
+			const unsigned char b = e < 0 || e > 255 ? 255 : (unsigned char)e;
+			const his::Idx idx = nearest[y][x];
+			bool good_idx;
+			if (e < 0)
+				good_idx = idx.x == -1 && idx.y == -1;
+			else
+				good_idx = idx.x >= 0 && idx.x < cols && idx.y >= 0 && idx.y < rows && mask[idx.y][idx.x]
+					&& (long long)(idx.x - x) * (idx.x - x) + (long long)(idx.y - y) * (idx.y - y) == e;
+
+			if (distance[y][x] != d || with_nearest[y][x] != d || bytes[y][x] != b || !good_idx)
+			{
+				printf("Error %s, %dx%d, %d threads: at (%d, %d) %g, %g, %d, nearest (%d, %d), expected %lld\n",
+					name, rows, cols, threads, x, y, distance[y][x], with_nearest[y][x], int(bytes[y][x]),
+					idx.x, idx.y, e);
+				return;
+			}
+		}
+}
+
+his::Matrix<unsigned char> RandomMask(int rows, int cols, int percent)
+{
+	his::Matrix<unsigned char> mask(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			mask[y][x] = rand() % 100 < percent;
+	return mask;
+}
+
+his::Matrix<unsigned char> FilledMask(int rows, int cols, unsigned char value)
+{
+	his::Matrix<unsigned char> mask(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			mask[y][x] = value;
+	return mask;
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3, 8 };
+	for (int t = 0; t < 4; ++t)
+	{
+		TestDistanceTransform(RandomMask(37, 41, 1), "sparse", threads[t]);
+		TestDistanceTransform(RandomMask(37, 41, 10), "10%", threads[t]);
+		TestDistanceTransform(RandomMask(29, 31, 60), "60%", threads[t]);
+		TestDistanceTransform(RandomMask(1, 50, 5), "one row", threads[t]);
+		TestDistanceTransform(RandomMask(50, 1, 5), "one column", threads[t]);
+		TestDistanceTransform(FilledMask(23, 19, 0), "empty", threads[t]);
+		TestDistanceTransform(FilledMask(23, 19, 1), "all features", threads[t]);
+		TestDistanceTransform(FilledMask(1, 1, 0), "empty 1x1", threads[t]);
+		TestDistanceTransform(FilledMask(0, 5, 0), "no rows", threads[t]);
+		TestDistanceTransform(FilledMask(5, 0, 0), "no columns", threads[t]);
+
+		his::Matrix<unsigned char> corner = FilledMask(40, 45, 0);
+		corner[39][44] = 1;
+		TestDistanceTransform(corner, "one corner", threads[t]);
+
+		// features in a single row, every other row finds them through the column pass
+		his::Matrix<unsigned char> line = FilledMask(33, 27, 0);
+		line[16][5] = line[16][20] = 1;
+		TestDistanceTransform(line, "one row of features", threads[t]);
+	}
+	return 0;
+}
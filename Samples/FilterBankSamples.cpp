@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Convolution.hpp"
+#include "his/ImageProcessing/Filter.hpp"
+#include "his/ImageProcessing/FilterBank.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+const int K = 3;
+
+his::Matrix<float> RandomKernel(int rows, int cols)
+{
+	his::Matrix<float> kernel(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			kernel[y][x] = float(rand()) / RAND_MAX * 2 - 1;
+	return kernel;
+}
+
+his::Matrix<float> Rotated(const his::Matrix<float> &kernel)
+{
+	his::Matrix<float> rotated(kernel.rows(), kernel.cols());
+	for (int y = 0; y < kernel.rows(); ++y)
+		for (int x = 0; x < kernel.cols(); ++x)
+			rotated[y][x] = kernel[kernel.rows() - 1 - y][kernel.cols() - 1 - x];
+	return rotated;
+}
+
+/*
+	filter_bank over a random 8-bit image with asymmetric kernels, so
+	that a flipped kernel shows:
+	1) in the interior, against filter() with a plain weighted sum,
+	   which is a correlation too, and trims the kernel at the borders
+	   only, when the image is large enough for filter();
+	2) everywhere, against convolve() with the kernels rotated by 180
+	   degrees, which has the same replicated borders;
+	3) the Dst[K] overload against the one output per kernel.
+*/
+void TestFilterBank(int rows, int cols, int krows, int kcols, int threads)
+{
+	his::Matrix<unsigned char> input(rows, cols);
+	his::Matrix<float> image(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			image[y][x] = input[y][x] = (unsigned char)(rand() % 256);
+
+	vector<his::Matrix<float>> kernels, responses;
+	vector<his::MatrixWrapper<float>> kernel_wrappers, response_wrappers;
+	for (int k = 0; k < K; ++k)
+	{
+		kernels.push_back(RandomKernel(krows, kcols));
+		responses.push_back(his::Matrix<float>(rows, cols));
+		kernel_wrappers.push_back(his::MatrixWrapper<float>(kernels[k]));
+		response_wrappers.push_back(his::MatrixWrapper<float>(responses[k]));
+	}
+	his::filter_bank(his::MatrixWrapper<unsigned char>(input), response_wrappers, kernel_wrappers, threads);
+
+	his::Matrix<short[K]> stacked(rows, cols);
+	his::filter_bank(his::MatrixWrapper<unsigned char>(input), his::MatrixWrapper<short[K]>(stacked),
+		kernel_wrappers, threads);
+
+	const int ry = krows / 2, rx = kcols / 2;
+	const float tolerance = 1e-5f * 255 * krows * kcols;
+	for (int k = 0; k < K; ++k)
+	{
+		his::Matrix<float> expected(rows, cols);
+		float error = 0, sum = 0;
+		if (krows * 2 + 1 < rows && kcols * 2 + 1 < cols)
+		{
+			his::filter(his::MatrixWrapper<float>(image), his::MatrixWrapper<float>(expected),
+				his::MatrixWrapper<float>(kernels[k]),
+				[&](float v, float w)
+			{
+				sum += v * w;
+			},
+				[&](float &out)
+			{
+				out = sum;
+				sum = 0;
+			});
+			for (int y = ry; y < rows - ry; ++y)
+				for (int x = rx; x < cols - rx; ++x)
+					error = max(error, fabs(responses[k][y][x] - expected[y][x]));
+			if (error > tolerance)
+				printf("Error %dx%d, kernel %d of %dx%d, %d threads: error %f against filter\n",
+					rows, cols, k, krows, kcols, threads, error);
+		}
+
+		his::convolve(his::MatrixWrapper<float>(image), his::MatrixWrapper<float>(expected),
+			his::MatrixWrapper<float>(Rotated(kernels[k])), threads);
+		error = 0;
+		for (int y = 0; y < rows; ++y)
+			for (int x = 0; x < cols; ++x)
+				error = max(error, fabs(responses[k][y][x] - expected[y][x]));
+		if (error > tolerance)
+			printf("Error %dx%d, kernel %d of %dx%d, %d threads: error %f against convolve\n",
+				rows, cols, k, krows, kcols, threads, error);
+
+		for (int y = 0; y < rows; ++y)
+			for (int x = 0; x < cols; ++x)
+				if (stacked[y][x][k] != his::saturate_cast<short>(responses[k][y][x]))
+				{
+					printf("Error %dx%d, kernel %d of %dx%d, %d threads: %d at (%d, %d), expected %d\n",
+						rows, cols, k, krows, kcols, threads, int(stacked[y][x][k]), x, y,
+						int(his::saturate_cast<short>(responses[k][y][x])));
+					y = rows;
+					break;
+				}
+	}
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestFilterBank(37, 41, 1, 1, threads[t]);
+		TestFilterBank(37, 41, 3, 5, threads[t]);
+		TestFilterBank(53, 47, 9, 7, threads[t]);
+		TestFilterBank(40, 61, 15, 15, threads[t]);
+		TestFilterBank(5, 3, 11, 7, threads[t]);
+	}
+	return 0;
+}
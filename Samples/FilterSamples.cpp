@@ -7,10 +7,15 @@
 	Opencv:	http://opencv.org/
 */
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
 #include <opencv2/opencv.hpp>
 
 #include "his/ImageProcessing/MatrixWrapper.hpp"
 #include "his/ImageProcessing/Filter.hpp"
+#include "his/ImageProcessing/FixedPointFilter.hpp"
 
 /*
 	A Gaussian Blur sample with function filter.
@@ -49,8 +54,72 @@ void GaussianBlurByFilter()
 }
 
 
+/*
+	The same blur with a quantized kernel and integer accumulation,
+	compared to the float path for speed and accuracy.
+	The borders are handled differently (trimmed kernel vs replicated
+	pixels), only the inner part is compared.
+*/
+void GaussianBlurFixedPoint()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	cv::Mat3b image = cv::imread("lena.jpg");
+	cv::Mat3b blur_float(image.size()), blur_fixed(image.size());
+	his::MatrixWrapper<uchar[3]> image_wrapper(image.data, image.rows, image.cols);
+	his::Matrix<float> kernel = his::gaussian_kernel<float>(11, 11, 10);
+
+	auto start = Clock::now();
+	float sum_rgb[3] = {0, 0, 0}, sum_w = 0;
+	his::filter(image_wrapper,
+		his::MatrixWrapper<uchar[3]>(blur_float.data, blur_float.rows, blur_float.cols),
+		kernel,
+		[&](const uchar rgb[3], float w)
+	{
+		for (int i = 0; i < 3; ++i)
+			sum_rgb[i] += rgb[i] * w;
+		sum_w += w;
+	},
+		[&](uchar rgb[3])
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			rgb[i] = uchar(sum_rgb[i] / sum_w + 0.5f);
+			sum_rgb[i] = 0;
+		}
+		sum_w = 0;
+	});
+	double float_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// 14 fractional bits, the weights still fit in 16 bits
+	const int shift = 14;
+	start = Clock::now();
+	his::filter_fixed(image_wrapper,
+		his::MatrixWrapper<uchar[3]>(blur_fixed.data, blur_fixed.rows, blur_fixed.cols),
+		his::quantize_kernel(kernel, shift), shift);
+	double fixed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	int max_diff = 0, diffs = 0;
+	for (int y = 5; y < image.rows - 5; ++y)
+	{
+		for (int x = 5; x < image.cols - 5; ++x)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				int diff = std::abs(blur_float(y, x)[c] - blur_fixed(y, x)[c]);
+				max_diff = std::max(max_diff, diff);
+				diffs += diff != 0;
+			}
+		}
+	}
+	printf("float: %.1f ms, fixed-point: %.1f ms\n", float_ms, fixed_ms);
+	printf("max difference %d, %d values differ\n", max_diff, diffs);
+}
+
+
 int main()
 {
 	GaussianBlurByFilter();
+	GaussianBlurFixedPoint();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+#include "his/ImageProcessing/Find.hpp"
+#include "his/ImageProcessing/Foreach.hpp"
+#include "his/ImageProcessing/IdxMap.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	Searches over a matrix where a fraction of the pixels at and after
+	a given position match, so that in parallel mode many threads find
+	a match at the same time, and the smallest one must win the race.
+	The results of find_if with 1 to 4 matrices, any_of and all_of are
+	compared with a serial for_each.
+*/
+void TestFind(int rows, int cols, int first_match, int percent, int threads)
+{
+	his::Matrix<int> m1(rows, cols), m2(rows, cols), m3(rows, cols), m4(rows, cols);
+	for (int y = 0; y < rows; ++y)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			int i = y * cols + x;
+			bool match = first_match >= 0 && (i == first_match
+				|| (i > first_match && rand() % 100 < percent));
+			m1[y][x] = match ? 1 : 0;
+			m2[y][x] = i;
+			m3[y][x] = -i;
+			m4[y][x] = 2 * i;
+		}
+	}
+
+	his::Idx expected(-1, -1);
+	bool all = true;
+	his::for_each(m1, his::IdxMap(rows, cols), [&](int m, his::Idx idx)
+	{
+		if (m && expected.x < 0)
+			expected = idx;
+		all = all && m;
+	});
+
+	// every overload passes the matching elements of all its matrices
+	his::Idx found[4] =
+	{
+		his::find_if(m1, [](int m) { return m != 0; }, threads),
+		his::find_if(m1, m2, [](int m, int i) { return m != 0 && i >= 0; }, threads),
+		his::find_if(m1, m2, m3, [](int m, int i, int j) { return m != 0 && i == -j; }, threads),
+		his::find_if(m1, m2, m3, m4, [](int m, int i, int j, int k)
+		{
+			return m != 0 && i == -j && k == 2 * i;
+		}, threads),
+	};
+	for (int k = 0; k < 4; ++k)
+		if (found[k].x != expected.x || found[k].y != expected.y)
+			printf("Error %dx%d, %d threads: find_if with %d matrices at (%d, %d), expected (%d, %d)\n",
+				rows, cols, threads, k + 1, found[k].x, found[k].y, expected.x, expected.y);
+
+	if (his::any_of(m1, [](int m) { return m != 0; }, threads) != (expected.x >= 0))
+		printf("Error %dx%d, %d threads: wrong any_of\n", rows, cols, threads);
+	if (his::all_of(m1, m2, [](int m, int) { return m != 0; }, threads) != all)
+		printf("Error %dx%d, %d threads: wrong all_of\n", rows, cols, threads);
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3, 8 };
+	for (int t = 0; t < 4; ++t)
+	{
+		// no match, and matches in the first and last pixels
+		TestFind(1, 1, -1, 0, threads[t]);
+		TestFind(1, 1, 0, 0, threads[t]);
+		TestFind(100, 37, -1, 0, threads[t]);
+		TestFind(100, 37, 0, 100, threads[t]);
+		TestFind(100, 37, 100 * 37 - 1, 0, threads[t]);
+
+		// a single match in the middle, then many after it
+		TestFind(200, 50, 5555, 0, threads[t]);
+		TestFind(200, 50, 5555, 30, threads[t]);
+		TestFind(1000, 20, 3 * 20 + 19, 100, threads[t]);
+		TestFind(1000, 20, 777 * 20, 5, threads[t]);
+	}
+
+	// races between many threads, over many random first matches
+	for (int i = 0; i < 200; ++i)
+		TestFind(300, 9, rand() % (300 * 9), rand() % 100, 8);
+	return 0;
+}
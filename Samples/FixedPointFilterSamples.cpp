@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+using namespace std;
+
+#include "his/ImageProcessing/Filter.hpp"
+#include "his/ImageProcessing/FixedPointFilter.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+
+/*
+	A brute-force reference of filter_fixed, accumulated in 64-bit
+	integers, with the border pixels replicated.
+*/
+template<int N>
+void ReferenceFilterFixed(const his::Matrix<unsigned char[N]> &input, his::Matrix<unsigned char[N]> &output,
+	const his::Matrix<short> &kernel, int shift)
+{
+	const int ry = kernel.rows() / 2, rx = kernel.cols() / 2;
+	for (int y = 0; y < input.rows(); ++y)
+	{
+		for (int x = 0; x < input.cols(); ++x)
+		{
+			for (int c = 0; c < N; ++c)
+			{
+				long long sum = 1LL << (shift - 1);
+				for (int ky = 0; ky < kernel.rows(); ++ky)
+				{
+					int sy = min(max(y + ky - ry, 0), input.rows() - 1);
+					for (int kx = 0; kx < kernel.cols(); ++kx)
+					{
+						int sx = min(max(x + kx - rx, 0), input.cols() - 1);
+						sum += (long long)kernel[ky][kx] * input[sy][sx][c];
+					}
+				}
+				output[y][x][c] = his::saturate_cast<unsigned char>(sum >> shift);
+			}
+		}
+	}
+}
+
+template<int N>
+void TestFilterFixed(int rows, int cols, const his::Matrix<short> &kernel, int shift, const char *name)
+{
+	typedef unsigned char Pixel[N];
+	his::Matrix<Pixel> input(rows, cols), output(rows, cols), expected(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				input[y][x][c] = (unsigned char)((x / 8 + y / 8) % 2 ? rand() % 256 : 255);
+
+	ReferenceFilterFixed(input, expected, kernel, shift);
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		his::filter_fixed(his::MatrixWrapper<Pixel>(input), his::MatrixWrapper<Pixel>(output),
+			kernel, shift, threads[t]);
+		for (int y = 0; y < rows; ++y)
+			for (int x = 0; x < cols; ++x)
+				for (int c = 0; c < N; ++c)
+					if (output[y][x][c] != expected[y][x][c])
+					{
+						printf("Error %s, %d threads: %d at (%d, %d), expected %d\n", name, threads[t],
+							output[y][x][c], x, y, expected[y][x][c]);
+						return;
+					}
+	}
+}
+
+int main()
+{
+	// a gaussian, accumulated in 32 bits
+	his::Matrix<short> gaussian = his::quantize_kernel(
+		his::MatrixWrapper<float>(his::gaussian_kernel<float>(11, 11, 3)), 14);
+	TestFilterFixed<1>(40, 37, gaussian, 14, "gaussian");
+	TestFilterFixed<3>(23, 41, gaussian, 14, "gaussian rgb");
+
+	// a signed kernel of large weights, whose sums overflow 32 bits
+	his::Matrix<short> large(21, 21);
+	for (int y = 0; y < 21; ++y)
+		for (int x = 0; x < 21; ++x)
+			large[y][x] = short(y == 0 ? -30000 : 30000);
+	TestFilterFixed<1>(30, 33, large, 14, "large signed");
+	TestFilterFixed<2>(30, 33, large, 14, "large signed, 2 channels");
+
+	// empty images
+	TestFilterFixed<1>(0, 0, gaussian, 14, "0x0");
+	TestFilterFixed<1>(0, 6, gaussian, 14, "0x6");
+	TestFilterFixed<3>(6, 0, gaussian, 14, "6x0");
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Foreach.hpp"
+#include "his/ImageProcessing/Histogram.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/RunLengthMask.hpp"
+
+// the bin of a value as documented, -1 out of [lo, hi)
+template<class Scalar>
+int Bin(Scalar v, int bins, double lo, double hi)
+{
+	double t = floor((double(v) - lo) * bins / (hi - lo));
+	return t >= 0 && t < bins ? int(t) : -1;
+}
+
+template<class Scalar>
+Scalar RandomValue();
+
+template<> unsigned char RandomValue<unsigned char>()
+{
+	// a few hot values, as in real images
+	return (unsigned char)(rand() % 4 == 0 ? 128 : rand() % 256);
+}
+
+template<> unsigned short RandomValue<unsigned short>()
+{
+	return (unsigned short)(rand() % 65536);
+}
+
+template<> float RandomValue<float>()
+{
+	// some values out of range, and NaN, which is never counted
+	if (rand() % 50 == 0)
+		return NAN;
+	return float(rand() % 10000) / 37.f - 30.f;
+}
+
+/*
+	Histograms of random images of N channels, of the whole image and
+	inside a random mask, compared with the counts of a serial
+	for_each.
+*/
+template<class Scalar, int N>
+void TestHistogram(int rows, int cols, int bins, double lo, double hi, int threads)
+{
+	typedef Scalar Pixel[N];
+	his::Matrix<Pixel> image(rows, cols);
+	his::Matrix<unsigned char> mask(rows, cols);
+	for (int y = 0; y < rows; ++y)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			for (int c = 0; c < N; ++c)
+				image[y][x][c] = RandomValue<Scalar>();
+			mask[y][x] = (x / 5 + y / 3) % 3 == 0 ? 255 : 0;
+		}
+	}
+
+	vector<int> expected(N * bins, 0), expected_masked(N * bins, 0);
+	his::for_each(image, mask, [&](const Pixel &p, unsigned char m)
+	{
+		for (int c = 0; c < N; ++c)
+		{
+			int b = Bin(p[c], bins, lo, hi);
+			if (b >= 0)
+			{
+				++expected[c * bins + b];
+				if (m)
+					++expected_masked[c * bins + b];
+			}
+		}
+	});
+
+	vector<int> result = his::histogram(his::MatrixWrapper<Pixel>(image), bins, lo, hi, threads);
+	if (result != expected)
+		printf("Error %zu bytes x %d channels, %dx%d, %d bins, %d threads: wrong histogram\n",
+			sizeof(Scalar), N, rows, cols, bins, threads);
+
+	his::RunLengthMask roi(mask);
+	result = his::histogram(roi, his::MatrixWrapper<Pixel>(image), bins, lo, hi, threads);
+	if (result != expected_masked)
+		printf("Error %zu bytes x %d channels, %dx%d, %d bins, %d threads: wrong masked histogram\n",
+			sizeof(Scalar), N, rows, cols, bins, threads);
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3, 8 };
+	for (int t = 0; t < 4; ++t)
+	{
+		TestHistogram<unsigned char, 1>(1, 1, 256, 0, 256, threads[t]);
+		TestHistogram<unsigned char, 1>(97, 131, 256, 0, 256, threads[t]);
+		TestHistogram<unsigned char, 1>(50, 7, 17, 10, 200, threads[t]);
+		TestHistogram<unsigned char, 3>(61, 83, 32, 0, 256, threads[t]);
+		TestHistogram<unsigned short, 1>(61, 83, 100, 0, 65536, threads[t]);
+		TestHistogram<unsigned short, 2>(7, 300, 64, 1000, 60000, threads[t]);
+		TestHistogram<float, 1>(61, 83, 50, -10, 200, threads[t]);
+		TestHistogram<float, 3>(33, 45, 7, 0, 1, threads[t]);
+	}
+	return 0;
+}
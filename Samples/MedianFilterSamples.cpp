@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/MedianFilter.hpp"
+
+/*
+	The brute-force rank of every window, with std::nth_element, the
+	borders replicated.
+*/
+template<class Scalar, int N>
+void ReferenceRank(const his::Matrix<Scalar[N]> &input, his::Matrix<Scalar[N]> &output,
+	int radius, double percentile)
+{
+	const int size = (2 * radius + 1) * (2 * radius + 1);
+	const int rank = int(percentile * (size - 1) + 0.5);
+	vector<Scalar> window(size);
+	for (int y = 0; y < input.rows(); ++y)
+	{
+		for (int x = 0; x < input.cols(); ++x)
+		{
+			for (int c = 0; c < N; ++c)
+			{
+				int i = 0;
+				for (int dy = -radius; dy <= radius; ++dy)
+				{
+					int sy = min(max(y + dy, 0), input.rows() - 1);
+					for (int dx = -radius; dx <= radius; ++dx)
+						window[i++] = input[sy][min(max(x + dx, 0), input.cols() - 1)][c];
+				}
+				nth_element(window.begin(), window.begin() + rank, window.end());
+				output[y][x][c] = window[rank];
+			}
+		}
+	}
+}
+
+/*
+	Random images of few levels, so that the windows have many ties,
+	filtered by rank_filter and compared with the reference.
+*/
+template<class Scalar, int N>
+void TestRankFilter(int rows, int cols, int radius, double percentile, int levels, int threads)
+{
+	typedef Scalar Pixel[N];
+	his::Matrix<Pixel> input(rows, cols), output(rows, cols), expected(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				input[y][x][c] = Scalar(rand() % levels * (sizeof(Scalar) == 1 ? 255 : 65535) / (levels - 1));
+
+	ReferenceRank(input, expected, radius, percentile);
+	if (percentile == 0.5)
+		his::median_filter(his::MatrixWrapper<Pixel>(input), his::MatrixWrapper<Pixel>(output),
+			radius, threads);
+	else
+		his::rank_filter(his::MatrixWrapper<Pixel>(input), his::MatrixWrapper<Pixel>(output),
+			radius, percentile, threads);
+
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				if (output[y][x][c] != expected[y][x][c])
+				{
+					printf("Error %d-bit, %d channels, %dx%d, radius %d, percentile %g, %d threads: "
+						"%d at (%d, %d), expected %d\n", int(sizeof(Scalar) * 8), N, rows, cols, radius,
+						percentile, threads, int(output[y][x][c]), x, y, int(expected[y][x][c]));
+					return;
+				}
+}
+
+template<class Scalar>
+void TestRankFilters(int threads)
+{
+	const int radii[] = { 0, 1, 2, 5 };
+	for (int r = 0; r < 4; ++r)
+	{
+		TestRankFilter<Scalar, 1>(37, 41, radii[r], 0.5, 256, threads);
+		TestRankFilter<Scalar, 1>(37, 41, radii[r], 0.5, 3, threads);
+		TestRankFilter<Scalar, 3>(19, 23, radii[r], 0.5, 17, threads);
+		TestRankFilter<Scalar, 1>(23, 19, radii[r], 0, 256, threads);
+		TestRankFilter<Scalar, 1>(23, 19, radii[r], 0.9, 256, threads);
+		TestRankFilter<Scalar, 2>(23, 19, radii[r], 1, 256, threads);
+	}
+
+	// windows wider and taller than the image
+	TestRankFilter<Scalar, 1>(5, 9, 7, 0.5, 256, threads);
+	TestRankFilter<Scalar, 1>(1, 1, 3, 0.5, 256, threads);
+	TestRankFilter<Scalar, 1>(1, 30, 4, 0.5, 256, threads);
+	TestRankFilter<Scalar, 1>(30, 1, 4, 0.3, 256, threads);
+	TestRankFilter<Scalar, 3>(6, 4, 20, 0.5, 256, threads);
+
+	// empty images
+	TestRankFilter<Scalar, 1>(0, 0, 2, 0.5, 256, threads);
+	TestRankFilter<Scalar, 1>(0, 6, 2, 0.5, 256, threads);
+	TestRankFilter<Scalar, 3>(6, 0, 2, 0.3, 256, threads);
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestRankFilters<unsigned char>(threads[t]);
+		TestRankFilters<unsigned short>(threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+using namespace std;
+
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/Morphology.hpp"
+
+/*
+	The naive erosion (dilation): the min (max) of the input over the
+	element centered on each pixel, the borders replicated.
+*/
+template<class Scalar, int N>
+void ReferenceMorphology(const his::Matrix<Scalar[N]> &input, his::Matrix<Scalar[N]> &output,
+	const his::Matrix<unsigned char> &element, bool dilation)
+{
+	const int ry = element.rows() / 2, rx = element.cols() / 2;
+	for (int y = 0; y < input.rows(); ++y)
+		for (int x = 0; x < input.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+			{
+				bool first = true;
+				Scalar result = Scalar();
+				for (int ey = 0; ey < element.rows(); ++ey)
+					for (int ex = 0; ex < element.cols(); ++ex)
+					{
+						if (!element[ey][ex])
+							continue;
+						int sy = min(max(y + ey - ry, 0), input.rows() - 1);
+						int sx = min(max(x + ex - rx, 0), input.cols() - 1);
+						Scalar v = input[sy][sx][c];
+						if (first || (dilation ? result < v : v < result))
+							result = v;
+						first = false;
+					}
+				output[y][x][c] = result;
+			}
+}
+
+template<class Scalar, int N>
+bool Same(const his::Matrix<Scalar[N]> &a, const his::Matrix<Scalar[N]> &b)
+{
+	for (int y = 0; y < a.rows(); ++y)
+		for (int x = 0; x < a.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+				if (a[y][x][c] != b[y][x][c])
+					return false;
+	return true;
+}
+
+template<class Scalar, int N>
+his::Matrix<Scalar[N]> Copy(const his::Matrix<Scalar[N]> &a)
+{
+	his::Matrix<Scalar[N]> b(a.rows(), a.cols());
+	for (int y = 0; y < a.rows(); ++y)
+		for (int x = 0; x < a.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+				b[y][x][c] = a[y][x][c];
+	return b;
+}
+
+/*
+	Erosion, dilation, opening and closing of a random image, compared
+	with the naive ones, composed for opening and closing. rect tells
+	that the element is a full rectangle, which then also goes through
+	the separable overloads. The last operation runs in place.
+*/
+template<class Scalar, int N>
+void TestMorphology(int rows, int cols, const his::Matrix<unsigned char> &element, bool rect,
+	const char *name, int threads)
+{
+	typedef Scalar Pixel[N];
+	his::Matrix<Pixel> input(rows, cols), output(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				input[y][x][c] = Scalar(rand() % 200 - (Scalar(-1) < 0 ? 100 : 0)) / Scalar(2);
+
+	his::Matrix<Pixel> eroded(rows, cols), dilated(rows, cols), opened(rows, cols), closed(rows, cols);
+	ReferenceMorphology(input, eroded, element, false);
+	ReferenceMorphology(input, dilated, element, true);
+	ReferenceMorphology(eroded, opened, element, true);
+	ReferenceMorphology(dilated, closed, element, false);
+
+	const int rx = element.cols() / 2, ry = element.rows() / 2;
+	his::MatrixWrapper<Pixel> in(input), out(output);
+	his::MatrixWrapper<unsigned char> e(element);
+	for (int pass = 0; pass < (rect ? 2 : 1); ++pass)
+	{
+		const char *overload = pass == 0 ? "element" : "rectangle";
+		if (pass == 0) his::erode(in, out, e, threads); else his::erode(in, out, rx, ry, threads);
+		if (!Same(output, eroded))
+			printf("Error %s, %s, %d threads: wrong erosion\n", name, overload, threads);
+		if (pass == 0) his::dilate(in, out, e, threads); else his::dilate(in, out, rx, ry, threads);
+		if (!Same(output, dilated))
+			printf("Error %s, %s, %d threads: wrong dilation\n", name, overload, threads);
+		if (pass == 0) his::opening(in, out, e, threads); else his::opening(in, out, rx, ry, threads);
+		if (!Same(output, opened))
+			printf("Error %s, %s, %d threads: wrong opening\n", name, overload, threads);
+
+		his::Matrix<Pixel> inplace = Copy(input);
+		his::MatrixWrapper<Pixel> io(inplace);
+		if (pass == 0) his::closing(io, io, e, threads); else his::closing(io, io, rx, ry, threads);
+		if (!Same(inplace, closed))
+			printf("Error %s, %s, %d threads: wrong closing in place\n", name, overload, threads);
+	}
+}
+
+his::Matrix<unsigned char> Rectangle(int rows, int cols)
+{
+	his::Matrix<unsigned char> element(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			element[y][x] = 1;
+	return element;
+}
+
+his::Matrix<unsigned char> Disk(int radius)
+{
+	his::Matrix<unsigned char> element(2 * radius + 1, 2 * radius + 1);
+	for (int y = 0; y < element.rows(); ++y)
+		for (int x = 0; x < element.cols(); ++x)
+			element[y][x] = (x - radius) * (x - radius) + (y - radius) * (y - radius) <= radius * radius;
+	return element;
+}
+
+// many runs of many lengths, not symmetric, not even connected
+his::Matrix<unsigned char> RandomElement(int rows, int cols)
+{
+	his::Matrix<unsigned char> element(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			element[y][x] = rand() % 3 != 0;
+	element[rows / 2][cols / 2] = 1;
+	return element;
+}
+
+template<class Scalar, int N>
+void TestMorphologies(int threads)
+{
+	TestMorphology<Scalar, N>(37, 43, Rectangle(1, 1), true, "1x1", threads);
+	TestMorphology<Scalar, N>(37, 43, Rectangle(3, 5), true, "3x5", threads);
+	TestMorphology<Scalar, N>(37, 43, Rectangle(7, 1), true, "7x1", threads);
+	TestMorphology<Scalar, N>(37, 43, Rectangle(11, 11), true, "11x11", threads);
+	TestMorphology<Scalar, N>(6, 5, Rectangle(15, 9), true, "15x9 over 6x5", threads);
+	TestMorphology<Scalar, N>(1, 40, Rectangle(3, 7), true, "3x7 over 1x40", threads);
+	TestMorphology<Scalar, N>(37, 43, Disk(3), false, "disk 3", threads);
+	TestMorphology<Scalar, N>(29, 31, Disk(7), false, "disk 7", threads);
+	TestMorphology<Scalar, N>(37, 43, RandomElement(7, 9), false, "random 7x9", threads);
+	TestMorphology<Scalar, N>(5, 4, RandomElement(9, 11), false, "random 9x11 over 5x4", threads);
+	TestMorphology<Scalar, N>(0, 0, Rectangle(3, 5), true, "3x5 over 0x0", threads);
+	TestMorphology<Scalar, N>(0, 6, Disk(2), false, "disk 2 over 0x6", threads);
+	TestMorphology<Scalar, N>(6, 0, Rectangle(3, 5), true, "3x5 over 6x0", threads);
+	TestMorphology<Scalar, N>(6, 0, Disk(2), false, "disk 2 over 6x0", threads);
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestMorphologies<unsigned char, 1>(threads[t]);
+		TestMorphologies<short, 3>(threads[t]);
+		TestMorphologies<float, 2>(threads[t]);
+	}
+	return 0;
+}
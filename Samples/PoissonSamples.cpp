@@ -30,31 +30,33 @@ void PoissonImageEditing()
 	cv::Mat3b image2 = cv::imread("lena2.jpg");
 	cv::Mat1b mask = cv::imread("face.png", cv::IMREAD_GRAYSCALE);
 	
-	his::Matrix<int> id_map(image1.rows, image2.cols);
-	id_map.set(-1);
-	int unknowns = 0;
-	his::for_each_pair(id_map, his::MatrixWrapper<uchar>(mask.data, mask.rows, mask.cols),
-		[&](int &id1, int &id2, uchar m1, uchar m2)
-	{
-		// Assign an id to each of the pixels of the INSIDE area, and
-		// those at the boundary(has at least one neighbor belonging 
-		// to the INSIDE area.
-		if (m1 == INSIDE || m2 == INSIDE)
-		{
-			if (id1 == -1)
-				id1 = unknowns++;
-			if (id2 == -1)
-				id2 = unknowns++;
-		}
-	});
+	// Assign an id to each of the pixels of the INSIDE area, and those 
+	// at the boundary(has at least one neighbor belonging to the INSIDE 
+	// area). The face is a small part of the image, so the passes 
+	// below only visit the runs of the masks, never the whole image.
+	his::MatrixWrapper<uchar> mask_wrapper(mask.data, mask.rows, mask.cols);
+	his::RunLengthMask face(mask_wrapper, [](uchar m) { return m == INSIDE; });
+
+	// The pairs touching the face cover the face and its boundary.
+	cv::Mat1b unknown(mask.size(), OUTSIDE);
+	his::MatrixWrapper<uchar> unknown_wrapper(unknown.data, unknown.rows, unknown.cols);
+	his::for_each(face, unknown_wrapper, [](uchar &u) { u = INSIDE; });
+	his::for_each_pair(face, unknown_wrapper, [](uchar &u1, uchar &u2) { u1 = u2 = INSIDE; });
+	his::RunLengthMask unknown_area(unknown_wrapper);
+
+	// Ids follow the row-major order, rows are numbered in parallel.
+	his::Matrix<int> id_map(image1.rows, image1.cols);
+	std::vector<his::Idx> positions;
+	int unknowns = his::compact_id_map(unknown_area, id_map, positions, 0);
 
 	Eigen::SparseMatrix<float> A(unknowns, unknowns);
 	A.reserve(Eigen::VectorXi::Constant(A.rows(), 5));
 	Eigen::MatrixXf b(unknowns, 3); b.setZero();
 
-	his::for_each_pair(id_map, his::MatrixWrapper<uchar[3]>(image2.data, image2.rows, image2.cols),
+	his::for_each_pair(unknown_area, id_map, his::MatrixWrapper<uchar[3]>(image2.data, image2.rows, image2.cols),
 		[&](int id1, int id2, const uchar rgb1[3], const uchar rgb2[3])
 	{
+		// A pair of the unknown area may still cross its border.
 		if (id1 >= 0 && id2 >= 0)
 		{
 			// Claim that neighboring pixels hold the gradients from image2
@@ -72,11 +74,11 @@ void PoissonImageEditing()
 		}
 	});
 
-	his::for_each(id_map, his::MatrixWrapper<uchar>(mask.data, mask.rows, mask.cols),
+	his::for_each(unknown_area, id_map, mask_wrapper,
 		his::MatrixWrapper<uchar[3]>(image1.data, image1.rows, image1.cols),
 		[&](int id, uchar m, const uchar rgb[3])
 	{
-		if (id >= 0 && m == OUTSIDE) // Boundary pixels
+		if (m == OUTSIDE) // Boundary pixels
 		{
 			// Claim that boundary pixels stay the same as image1.
 			A.coeffRef(id, id) += 1;
@@ -89,16 +91,15 @@ void PoissonImageEditing()
 	Eigen::SimplicialCholesky<decltype(A)> solver(A);
 	b = solver.solve(b);
 
-	his::for_each(id_map, his::MatrixWrapper<uchar[3]>(image1.data, image1.rows, image1.cols),
-		[&](int id, uchar rgb[3])
+	// Assign pixels with the solution of the equation, the positions
+	// list maps each unknown back to its pixel.
+	his::MatrixWrapper<uchar[3]> image1_wrapper(image1.data, image1.rows, image1.cols);
+	for (int id = 0; id < unknowns; ++id)
 	{
-		if (id >= 0)
-		{
-			// Assign pixels with the solution of the equation.
-			for (int c = 0; c < 3; ++c)
-				rgb[c] = (uchar)MAX(0, MIN(b(id, c)+0.5, 255));
-		}
-	});
+		uchar *rgb = image1_wrapper(positions[id]);
+		for (int c = 0; c < 3; ++c)
+			rgb[c] = his::saturate_cast<uchar>(b(id, c));
+	}
 
 	cv::imwrite("monalena.jpg", image1);
 }
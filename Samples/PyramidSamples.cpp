@@ -0,0 +1,216 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+using namespace std;
+
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/Pyramid.hpp"
+
+const double W[5] = { 1, 4, 6, 4, 1 };
+
+int Clamp(int v, int size)
+{
+	return min(max(v, 0), size - 1);
+}
+
+/*
+	The brute-force [1 4 6 4 1]/16 blur in both directions, sampled at
+	the even rows and columns, the borders replicated.
+*/
+template<int N>
+his::Matrix<double[N]> ReferenceReduce(const his::Matrix<double[N]> &input)
+{
+	const int rows = input.rows(), cols = input.cols();
+	his::Matrix<double[N]> output((rows + 1) / 2, (cols + 1) / 2);
+	for (int y = 0; y < output.rows(); ++y)
+		for (int x = 0; x < output.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+			{
+				double sum = 0;
+				for (int i = 0; i < 5; ++i)
+					for (int j = 0; j < 5; ++j)
+						sum += W[i] * W[j] * input[Clamp(2 * y + i - 2, rows)][Clamp(2 * x + j - 2, cols)][c];
+				output[y][x][c] = sum / 256;
+			}
+	return output;
+}
+
+/*
+	The brute-force expand of Burt and Adelson: the input spread on the
+	even rows and columns of the output, zeros between them, blurred by
+	4 times the same kernel, the input borders replicated.
+*/
+template<int N>
+his::Matrix<double[N]> ReferenceExpand(const his::Matrix<double[N]> &input, int rows, int cols)
+{
+	his::Matrix<double[N]> output(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+			{
+				double sum = 0;
+				for (int i = 0; i < 5; ++i)
+					for (int j = 0; j < 5; ++j)
+					{
+						int sy = y + i - 2, sx = x + j - 2;
+						if (sy % 2 == 0 && sx % 2 == 0)
+							sum += W[i] * W[j] * input[Clamp(sy / 2, input.rows())][Clamp(sx / 2, input.cols())][c];
+					}
+				output[y][x][c] = sum * 4 / 256;
+			}
+	return output;
+}
+
+template<class T, int N>
+double MaxError(const his::Matrix<T[N]> &a, const his::Matrix<double[N]> &b)
+{
+	double error = 0;
+	for (int y = 0; y < a.rows(); ++y)
+		for (int x = 0; x < a.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+				error = max(error, fabs(a[y][x][c] - b[y][x][c]));
+	return error;
+}
+
+template<class T, int N>
+his::Matrix<double[N]> ToDouble(const his::Matrix<T[N]> &a)
+{
+	his::Matrix<double[N]> b(a.rows(), a.cols());
+	for (int y = 0; y < a.rows(); ++y)
+		for (int x = 0; x < a.cols(); ++x)
+			for (int c = 0; c < N; ++c)
+				b[y][x][c] = a[y][x][c];
+	return b;
+}
+
+/*
+	pyramid_reduce and pyramid_expand of a random image, odd or even
+	sizes, against the references: float outputs within float rounding,
+	8-bit outputs within the rounding of the last bit. The expand goes
+	to both the even size and one less.
+*/
+template<int N>
+void TestReduceExpand(int rows, int cols, int threads)
+{
+	typedef float Pixel[N];
+	typedef unsigned char Byte[N];
+	his::Matrix<Byte> input(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				input[y][x][c] = (unsigned char)(rand() % 256);
+
+	const int half_rows = (rows + 1) / 2, half_cols = (cols + 1) / 2;
+	his::Matrix<double[N]> reduced = ReferenceReduce(ToDouble(input));
+	his::Matrix<Pixel> small(half_rows, half_cols);
+	his::Matrix<Byte> small_bytes(half_rows, half_cols);
+	his::pyramid_reduce(his::MatrixWrapper<Byte>(input), his::MatrixWrapper<Pixel>(small), threads);
+	his::pyramid_reduce(his::MatrixWrapper<Byte>(input), his::MatrixWrapper<Byte>(small_bytes), threads);
+	double error = MaxError(small, reduced), byte_error = MaxError(small_bytes, reduced);
+	if (error > 1e-3 || byte_error > 0.5 + 1e-3)
+		printf("Error reduce %dx%d, %d channels, %d threads: error %g, 8-bit %g\n",
+			rows, cols, N, threads, error, byte_error);
+
+	const int sizes[2][2] = { { 2 * half_rows, 2 * half_cols }, { 2 * half_rows - 1, 2 * half_cols - 1 } };
+	for (int s = 0; s < 2; ++s)
+	{
+		const int out_rows = sizes[s][0], out_cols = sizes[s][1];
+		his::Matrix<double[N]> expanded = ReferenceExpand(ToDouble(small), out_rows, out_cols);
+		his::Matrix<Pixel> large(out_rows, out_cols);
+		his::Matrix<Byte> large_bytes(out_rows, out_cols);
+		his::pyramid_expand(his::MatrixWrapper<Pixel>(small), his::MatrixWrapper<Pixel>(large), threads);
+		his::pyramid_expand(his::MatrixWrapper<Pixel>(small), his::MatrixWrapper<Byte>(large_bytes), threads);
+		error = MaxError(large, expanded), byte_error = MaxError(large_bytes, expanded);
+		if (error > 1e-3 || byte_error > 0.5 + 1e-3)
+			printf("Error expand %dx%d to %dx%d, %d channels, %d threads: error %g, 8-bit %g\n",
+				half_rows, half_cols, out_rows, out_cols, N, threads, error, byte_error);
+	}
+}
+
+/*
+	A laplacian pyramid of a random 8-bit image, each band compared with
+	the references, then collapsed back to the image: exactly in 8 bits,
+	within float rounding in float.
+*/
+template<int N>
+void TestLaplacian(int rows, int cols, int levels, int threads)
+{
+	typedef float Pixel[N];
+	typedef unsigned char Byte[N];
+	his::Matrix<Byte> image(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			for (int c = 0; c < N; ++c)
+				image[y][x][c] = (unsigned char)(rand() % 256);
+
+	his::Pyramid<Pixel> bands(rows, cols, levels);
+	his::laplacian_pyramid(his::MatrixWrapper<Byte>(image), bands, threads);
+
+	his::Matrix<double[N]> gaussian = ToDouble(image);
+	for (int l = 0; l < bands.levels(); ++l)
+	{
+		his::Matrix<double[N]> band = gaussian;
+		if (l + 1 < bands.levels())
+		{
+			his::Matrix<double[N]> next = ReferenceReduce(gaussian);
+			his::Matrix<double[N]> expanded = ReferenceExpand(next, gaussian.rows(), gaussian.cols());
+			band = his::Matrix<double[N]>(gaussian.rows(), gaussian.cols());
+			for (int y = 0; y < band.rows(); ++y)
+				for (int x = 0; x < band.cols(); ++x)
+					for (int c = 0; c < N; ++c)
+						band[y][x][c] = gaussian[y][x][c] - expanded[y][x][c];
+			gaussian = next;
+		}
+		double error = MaxError(bands[l], band);
+		if (error > 1e-3)
+			printf("Error laplacian %dx%d, %d levels, %d channels, %d threads: level %d error %g\n",
+				rows, cols, bands.levels(), N, threads, l, error);
+	}
+
+	his::Matrix<Byte> bytes(rows, cols);
+	his::Matrix<Pixel> floats(rows, cols);
+	his::collapse(bands, his::MatrixWrapper<Byte>(bytes), threads);
+	his::collapse(bands, his::MatrixWrapper<Pixel>(floats), threads);
+	his::Matrix<double[N]> expected = ToDouble(image);
+	double byte_error = MaxError(bytes, expected), error = MaxError(floats, expected);
+	if (byte_error != 0 || error > 1e-3)
+		printf("Error collapse %dx%d, %d levels, %d channels, %d threads: error %g, 8-bit %g\n",
+			rows, cols, bands.levels(), N, threads, error, byte_error);
+}
+
+/*
+	Empty images are left alone.
+*/
+void TestEmpty(int rows, int cols)
+{
+	his::Matrix<float> large(rows, cols), small((rows + 1) / 2, (cols + 1) / 2);
+	his::pyramid_reduce(his::MatrixWrapper<float>(large), his::MatrixWrapper<float>(small), 3);
+	his::pyramid_expand(his::MatrixWrapper<float>(small), his::MatrixWrapper<float>(large), 3);
+}
+
+int main()
+{
+	TestEmpty(0, 0);
+	TestEmpty(0, 6);
+	TestEmpty(6, 0);
+
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestReduceExpand<1>(37, 41, threads[t]);
+		TestReduceExpand<1>(32, 48, threads[t]);
+		TestReduceExpand<3>(21, 14, threads[t]);
+		TestReduceExpand<1>(1, 9, threads[t]);
+		TestReduceExpand<1>(9, 1, threads[t]);
+		TestReduceExpand<2>(1, 1, threads[t]);
+		TestReduceExpand<1>(3, 2, threads[t]);
+
+		TestLaplacian<1>(37, 41, 4, threads[t]);
+		TestLaplacian<3>(64, 48, 6, threads[t]);
+		TestLaplacian<1>(1, 13, 10, threads[t]);
+		TestLaplacian<2>(23, 5, 10, threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Filter.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/RecursiveGaussian.hpp"
+
+/*
+	A test image in [0, 255]: noise over a ramp, so that the borders
+	are not flat and their initialization matters.
+*/
+his::Matrix<float> TestImage(int rows, int cols)
+{
+	his::Matrix<float> image(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			image[y][x] = float(x + y) / (rows + cols) * 155 + rand() % 101;
+	return image;
+}
+
+/*
+	The sampled gaussian with replicated borders, separable, in double.
+*/
+his::Matrix<float> ReplicatedGaussian(const his::Matrix<float> &image, double sigma, int radius)
+{
+	const int rows = image.rows(), cols = image.cols();
+	vector<double> w(2 * radius + 1);
+	double sum = 0;
+	for (int k = -radius; k <= radius; ++k)
+		sum += w[k + radius] = exp(-0.5 * k * k / (sigma * sigma));
+
+	vector<double> horizontal(rows * cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			double acc = 0;
+			for (int k = -radius; k <= radius; ++k)
+				acc += w[k + radius] * image[y][min(max(x + k, 0), cols - 1)];
+			horizontal[y * cols + x] = acc / sum;
+		}
+
+	his::Matrix<float> result(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+		{
+			double acc = 0;
+			for (int k = -radius; k <= radius; ++k)
+				acc += w[k + radius] * horizontal[min(max(y + k, 0), rows - 1) * cols + x];
+			result[y][x] = float(acc / sum);
+		}
+	return result;
+}
+
+/*
+	recursive_gaussian compared with filter and gaussian_kernel in the
+	interior, where filter does not trim its kernel, and with the
+	replicated-border gaussian everywhere, which checks the initial
+	states of Triggs and Sdika at the four borders. The errors are in
+	gray levels of the [0, 255] image.
+*/
+void TestRecursiveGaussian(double sigma, float max_error, int threads)
+{
+	const int radius = int(ceil(4 * sigma)), size = 2 * radius + 1;
+	const int rows = 2 * size + 9, cols = 2 * size + 14;
+	his::Matrix<float> image = TestImage(rows, cols);
+	his::Matrix<float> blurred(rows, cols);
+	his::recursive_gaussian(his::MatrixWrapper<float>(image), his::MatrixWrapper<float>(blurred),
+		sigma, threads);
+
+	// interior, against filter
+	his::Matrix<float> expected(rows, cols);
+	float sum = 0, sum_w = 0;
+	his::filter(his::MatrixWrapper<float>(image), his::MatrixWrapper<float>(expected),
+		his::MatrixWrapper<float>(his::gaussian_kernel<float>(size, size, sigma)),
+		[&](float v, float w)
+	{
+		sum += v * w;
+		sum_w += w;
+	},
+		[&](float &out)
+	{
+		out = sum / sum_w;
+		sum = sum_w = 0;
+	});
+
+	float interior_error = 0;
+	for (int y = radius; y < rows - radius; ++y)
+		for (int x = radius; x < cols - radius; ++x)
+			interior_error = max(interior_error, fabs(blurred[y][x] - expected[y][x]));
+	if (interior_error > max_error)
+		printf("Error sigma %g, %d threads: interior error %f, over %f\n",
+			sigma, threads, interior_error, max_error);
+
+	// everywhere, against replicated borders
+	expected = ReplicatedGaussian(image, sigma, radius);
+	float border_error = 0;
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			border_error = max(border_error, fabs(blurred[y][x] - expected[y][x]));
+	if (border_error > max_error)
+		printf("Error sigma %g, %d threads: border error %f, over %f\n",
+			sigma, threads, border_error, max_error);
+
+	// 8-bit output, in place, the same values rounded
+	his::Matrix<unsigned char> gray(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			gray[y][x] = his::saturate_cast<unsigned char>(image[y][x]);
+	his::recursive_gaussian(his::MatrixWrapper<unsigned char>(gray),
+		his::MatrixWrapper<unsigned char>(gray), sigma, threads);
+	float gray_error = 0;
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			gray_error = max(gray_error, fabs(gray[y][x] - expected[y][x]));
+	if (gray_error > max_error + 1)
+		printf("Error sigma %g, %d threads: 8-bit error %f, over %f\n",
+			sigma, threads, gray_error, max_error + 1);
+}
+
+/*
+	Empty images are left alone.
+*/
+void TestEmpty(int rows, int cols)
+{
+	his::Matrix<float> input(rows, cols), output(rows, cols);
+	his::recursive_gaussian(his::MatrixWrapper<float>(input), his::MatrixWrapper<float>(output), 2.0, 3);
+	his::Matrix<unsigned char[3]> gray(rows, cols);
+	his::recursive_gaussian(his::MatrixWrapper<unsigned char[3]>(gray),
+		his::MatrixWrapper<unsigned char[3]>(gray), 2.0, 3);
+}
+
+int main()
+{
+	TestEmpty(0, 0);
+	TestEmpty(0, 17);
+	TestEmpty(17, 0);
+
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestRecursiveGaussian(2, 2.f, threads[t]);
+		TestRecursiveGaussian(3.5, 1.f, threads[t]);
+		TestRecursiveGaussian(6, 0.8f, threads[t]);
+		TestRecursiveGaussian(10, 0.8f, threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+using namespace std;
+
+#include "his/ImageProcessing/Foreach.hpp"
+#include "his/ImageProcessing/IdxMap.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/Reduce.hpp"
+
+typedef pair<int, his::Idx> Candidate;
+
+// the smaller value, ties broken by position to stay commutative
+Candidate Smaller(const Candidate &a, const Candidate &b)
+{
+	if (a.first != b.first)
+		return a.first < b.first ? a : b;
+	return a.second.y < b.second.y || (a.second.y == b.second.y
+		&& a.second.x < b.second.x) ? a : b;
+}
+
+/*
+	Reductions of random integer matrices with 1 to 4 inputs, compared
+	with the same accumulation done by a serial for_each. The values
+	are integers, so the results must be exact whatever the order of
+	the lanes and threads.
+*/
+void TestReduce(int rows, int cols, int threads)
+{
+	his::Matrix<int> m1(rows, cols), m2(rows, cols), m3(rows, cols), m4(rows, cols);
+	for (int y = 0; y < rows; ++y)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			// few values, so that the minimum has ties
+			m1[y][x] = rand() % 50 - 25;
+			m2[y][x] = rand() % 1000;
+			m3[y][x] = rand() % 1000 - 500;
+			m4[y][x] = rand() % 7;
+		}
+	}
+
+	// 1 matrix
+	long long sum = 0;
+	his::for_each(m1, [&](int a) { sum += a; });
+	long long reduced = his::reduce(m1, 0LL, plus<long long>(), threads);
+	if (reduced != sum)
+		printf("Error %dx%d, %d threads: sum %lld, expected %lld\n", rows, cols, threads, reduced, sum);
+
+	// 2 matrices
+	long long dot = 0;
+	his::for_each(m1, m2, [&](int a, int b) { dot += a * b; });
+	reduced = his::transform_reduce(m1, m2, 0LL, plus<long long>(),
+		[](int a, int b) -> long long { return a * b; }, threads);
+	if (reduced != dot)
+		printf("Error %dx%d, %d threads: dot %lld, expected %lld\n", rows, cols, threads, reduced, dot);
+
+	// 3 matrices
+	int minimum = INT_MAX;
+	his::for_each(m1, m2, m3, [&](int a, int b, int c) { minimum = min(minimum, a * b + c); });
+	int min_reduced = his::transform_reduce(m1, m2, m3, INT_MAX,
+		[](int a, int b) { return min(a, b); },
+		[](int a, int b, int c) { return a * b + c; }, threads);
+	if (min_reduced != minimum)
+		printf("Error %dx%d, %d threads: min %d, expected %d\n", rows, cols, threads, min_reduced, minimum);
+
+	// 4 matrices
+	int maximum = INT_MIN;
+	his::for_each(m1, m2, m3, m4, [&](int a, int b, int c, int d) { maximum = max(maximum, a - b + c * d); });
+	int max_reduced = his::transform_reduce(m1, m2, m3, m4, INT_MIN,
+		[](int a, int b) { return max(a, b); },
+		[](int a, int b, int c, int d) { return a - b + c * d; }, threads);
+	if (max_reduced != maximum)
+		printf("Error %dx%d, %d threads: max %d, expected %d\n", rows, cols, threads, max_reduced, maximum);
+
+	// the first position of the minimum, through an IdxMap
+	Candidate darkest(INT_MAX, his::Idx(-1, -1));
+	his::for_each(m1, his::IdxMap(rows, cols), [&](int v, his::Idx idx)
+	{
+		if (v < darkest.first)
+			darkest = Candidate(v, idx);
+	});
+	Candidate found = his::transform_reduce(m1, his::IdxMap(rows, cols),
+		Candidate(INT_MAX, his::Idx(-1, -1)), Smaller,
+		[](int v, his::Idx idx) { return Candidate(v, idx); }, threads);
+	if (found.first != darkest.first || found.second.x != darkest.second.x
+		|| found.second.y != darkest.second.y)
+		printf("Error %dx%d, %d threads: argmin (%d, %d), expected (%d, %d)\n", rows, cols, threads,
+			found.second.x, found.second.y, darkest.second.x, darkest.second.y);
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3, 8 };
+	for (int t = 0; t < 4; ++t)
+	{
+		TestReduce(1, 1, threads[t]);
+		TestReduce(1, 7, threads[t]);
+		TestReduce(13, 1, threads[t]);
+		TestReduce(5, 3, threads[t]);
+		TestReduce(64, 64, threads[t]);
+		TestReduce(123, 257, threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/Remap.hpp"
+
+const his::Interpolation interpolations[] =
+{
+	his::INTERPOLATION_NEAREST, his::INTERPOLATION_BILINEAR, his::INTERPOLATION_BICUBIC
+};
+const char *names[] = { "nearest", "bilinear", "bicubic" };
+
+his::Matrix<float> RandomImage(int rows, int cols)
+{
+	his::Matrix<float> image(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			image[y][x] = float(rand()) / RAND_MAX;
+	return image;
+}
+
+// a ramp in [0, 1], which bilinear and bicubic reproduce away from the borders
+his::Matrix<float> Ramp(int rows, int cols)
+{
+	his::Matrix<float> image(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			image[y][x] = float((0.6 * x / cols + 0.4 * y / rows));
+	return image;
+}
+
+float MaxError(const his::Matrix<float> &a, const his::Matrix<float> &b)
+{
+	float error = 0;
+	for (int y = 0; y < a.rows(); ++y)
+		for (int x = 0; x < a.cols(); ++x)
+			error = max(error, fabs(a[y][x] - b[y][x]));
+	return error;
+}
+
+/*
+	Maps onto the pixel centers of the source give the source back,
+	exactly, with every interpolation.
+*/
+void TestIdentity(int rows, int cols, int threads)
+{
+	his::Matrix<float> src = RandomImage(rows, cols), dst(rows, cols);
+	his::Matrix<float> map_x(rows, cols), map_y(rows, cols);
+	for (int y = 0; y < rows; ++y)
+		for (int x = 0; x < cols; ++x)
+			map_x[y][x] = float(x), map_y[y][x] = float(y);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		his::remap(his::MatrixWrapper<float>(src), his::MatrixWrapper<float>(dst),
+			his::MatrixWrapper<float>(map_x), his::MatrixWrapper<float>(map_y), interpolations[i], threads);
+		float error = MaxError(dst, src);
+		if (error != 0)
+			printf("Error identity %dx%d, %s, %d threads: error %g\n", rows, cols, names[i], threads, error);
+	}
+}
+
+/*
+	remap with the maps of a resize, the pixel centers aligned, against
+	resize itself. On a ramp, both are also compared with the ramp at
+	the mapped positions, away from the borders.
+*/
+void TestResize(const his::Matrix<float> &src, int dst_rows, int dst_cols, bool ramp, int threads)
+{
+	const int rows = src.rows(), cols = src.cols();
+	his::Matrix<float> resized(dst_rows, dst_cols), remapped(dst_rows, dst_cols);
+	his::Matrix<float> map_x(dst_rows, dst_cols), map_y(dst_rows, dst_cols);
+	const double scale_x = double(cols) / dst_cols, scale_y = double(rows) / dst_rows;
+	for (int y = 0; y < dst_rows; ++y)
+		for (int x = 0; x < dst_cols; ++x)
+		{
+			map_x[y][x] = float((x + 0.5) * scale_x - 0.5);
+			map_y[y][x] = float((y + 0.5) * scale_y - 0.5);
+		}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		his::resize(his::MatrixWrapper<float>(src), his::MatrixWrapper<float>(resized), interpolations[i], threads);
+		his::remap(his::MatrixWrapper<float>(src), his::MatrixWrapper<float>(remapped),
+			his::MatrixWrapper<float>(map_x), his::MatrixWrapper<float>(map_y), interpolations[i], threads);
+		float error = MaxError(resized, remapped);
+		if (error > 2e-5f)
+			printf("Error %s %dx%d to %dx%d, %s, %d threads: remap against resize %g\n",
+				ramp ? "ramp" : "random", rows, cols, dst_rows, dst_cols, names[i], threads, error);
+
+		if (!ramp || interpolations[i] == his::INTERPOLATION_NEAREST)
+			continue;
+		error = 0;
+		for (int y = 0; y < dst_rows; ++y)
+			for (int x = 0; x < dst_cols; ++x)
+			{
+				float sx = map_x[y][x], sy = map_y[y][x];
+				if (sx < 1 || sx > cols - 2 || sy < 1 || sy > rows - 2)
+					continue;
+				float expected = float(0.6 * sx / cols + 0.4 * sy / rows);
+				error = max(error, max(fabs(resized[y][x] - expected), fabs(remapped[y][x] - expected)));
+			}
+		if (error > 2e-5f)
+			printf("Error ramp %dx%d to %dx%d, %s, %d threads: error %g\n",
+				rows, cols, dst_rows, dst_cols, names[i], threads, error);
+	}
+}
+
+/*
+	Coordinates far outside of the source, infinite or NaN read the
+	border: the first pixel for those below the source and for NaN,
+	the last one for those above it.
+*/
+void TestOutside(int threads)
+{
+	const float inf = numeric_limits<float>::infinity(), nan = numeric_limits<float>::quiet_NaN();
+	const float coordinates[] = { -1e20f, -inf, -3.5f, nan, 1e20f, inf, 40.5f };
+	const int count = 7, rows = 9, cols = 11;
+	his::Matrix<float> src = RandomImage(rows, cols), dst(count, count);
+	his::Matrix<float> map_x(count, count), map_y(count, count);
+	for (int y = 0; y < count; ++y)
+		for (int x = 0; x < count; ++x)
+			map_x[y][x] = coordinates[x], map_y[y][x] = coordinates[y];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		his::remap(his::MatrixWrapper<float>(src), his::MatrixWrapper<float>(dst),
+			his::MatrixWrapper<float>(map_x), his::MatrixWrapper<float>(map_y), interpolations[i], threads);
+		for (int y = 0; y < count; ++y)
+			for (int x = 0; x < count; ++x)
+			{
+				float expected = src[y < 4 ? 0 : rows - 1][x < 4 ? 0 : cols - 1];
+				if (dst[y][x] != expected)
+					printf("Error outside, %s, %d threads: (%g, %g) gives %g, expected %g\n",
+						names[i], threads, coordinates[x], coordinates[y], dst[y][x], expected);
+			}
+	}
+}
+
+int main()
+{
+	const int threads[] = { 1, 0, 3 };
+	for (int t = 0; t < 3; ++t)
+	{
+		TestIdentity(37, 71, threads[t]);
+		TestIdentity(1, 1, threads[t]);
+
+		TestResize(RandomImage(37, 41), 80, 59, false, threads[t]);
+		TestResize(RandomImage(64, 48), 21, 17, false, threads[t]);
+		TestResize(RandomImage(1, 30), 3, 45, false, threads[t]);
+		TestResize(Ramp(37, 41), 80, 59, true, threads[t]);
+		TestResize(Ramp(64, 48), 21, 17, true, threads[t]);
+		TestResize(Ramp(20, 20), 20, 20, true, threads[t]);
+
+		TestOutside(threads[t]);
+	}
+	return 0;
+}
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "his/ImageProcessing/Foreach.hpp"
+#include "his/ImageProcessing/ForeachPair.hpp"
+#include "his/ImageProcessing/Matrix.hpp"
+#include "his/ImageProcessing/RunLengthMask.hpp"
+
+/*
+	The masked for_each/for_each_pair overloads must visit exactly what
+	the ordinary ones visit with an inside test in the functor: every
+	inside pixel once, and every neighboring pair with at least one
+	pixel inside once, including the pairs crossing the mask border.
+
+	The pixels hold their row-major index id, the k-th matrix holds
+	id + k*N, so the functors check that the elements of all matrices
+	come from the same pixel, and record the ids they are called with.
+*/
+class MaskTest
+{
+public:
+	MaskTest(int rows, int cols, int percent) : m_mask(rows, cols)
+	{
+		int n = rows * cols;
+		for (int k = 0; k < 4; ++k)
+			m_mats.push_back(his::Matrix<int>(rows, cols));
+		for (int y = 0; y < rows; ++y)
+		{
+			for (int x = 0; x < cols; ++x)
+			{
+				// blobs of inside pixels, so that there are long runs
+				bool inside = (x / 3 + y / 2) % 2 == 0 ? rand() % 100 < percent + 20
+					: rand() % 100 < percent - 20;
+				m_mask[y][x] = inside ? 255 : 0;
+				for (int k = 0; k < 4; ++k)
+					m_mats[k][y][x] = y * cols + x + k * n;
+			}
+		}
+		m_n = n;
+		m_runs = his::RunLengthMask(his::MatrixWrapper<unsigned char>(m_mask));
+	}
+
+	void Run()
+	{
+		if (m_runs.area() != size_t(count_inside()))
+			printf("Error %dx%d: area %zu, expected %d\n", m_mask.rows(), m_mask.cols(),
+				m_runs.area(), count_inside());
+
+		TestForeach();
+		TestForeachPair();
+	}
+
+private:
+	int count_inside() const
+	{
+		int inside = 0;
+		for (int y = 0; y < m_mask.rows(); ++y)
+			for (int x = 0; x < m_mask.cols(); ++x)
+				inside += m_mask[y][x] != 0;
+		return inside;
+	}
+
+	void check(vector<int> &visited, vector<int> &expected, const char *what)
+	{
+		sort(visited.begin(), visited.end());
+		sort(expected.begin(), expected.end());
+		if (visited != expected)
+			printf("Error %dx%d: %s visited %zu pixels, expected %zu\n",
+				m_mask.rows(), m_mask.cols(), what, visited.size(), expected.size());
+	}
+
+	void check(vector<pair<int, int>> &visited, vector<pair<int, int>> &expected, const char *what)
+	{
+		sort(visited.begin(), visited.end());
+		sort(expected.begin(), expected.end());
+		if (visited != expected)
+			printf("Error %dx%d: %s visited %zu pairs, expected %zu\n",
+				m_mask.rows(), m_mask.cols(), what, visited.size(), expected.size());
+	}
+
+	// an element of the k-th matrix, which does not come from pixel id
+	bool wrong(int id, int element, int k) const
+	{
+		return element != id + k * m_n;
+	}
+
+	void TestForeach()
+	{
+		const int n = m_n;
+		const unsigned char *mask = m_mask[0];
+		vector<int> expected, visited1, visited2, visited3, visited4;
+		int errors = 0;
+
+		his::for_each(m_mats[0], [&](int id)
+		{
+			if (mask[id])
+				expected.push_back(id);
+		});
+
+		his::for_each(m_runs, m_mats[0], [&](int id)
+		{
+			visited1.push_back(id);
+		});
+		his::for_each(m_runs, m_mats[0], m_mats[1], [&](int id, int e1)
+		{
+			errors += wrong(id, e1, 1);
+			visited2.push_back(id);
+		});
+		his::for_each(m_runs, m_mats[0], m_mats[1], m_mats[2], [&](int id, int e1, int e2)
+		{
+			errors += wrong(id, e1, 1) + wrong(id, e2, 2);
+			visited3.push_back(id);
+		});
+		his::for_each(m_runs, m_mats[0], m_mats[1], m_mats[2], m_mats[3],
+			[&](int id, int e1, int e2, int e3)
+		{
+			errors += wrong(id, e1, 1) + wrong(id, e2, 2) + wrong(id, e3, 3);
+			visited4.push_back(id);
+		});
+
+		if (errors > 0)
+			printf("Error %dx%d: masked for_each mixed up %d elements of %d pixels\n",
+				m_mask.rows(), m_mask.cols(), errors, n);
+		check(visited1, expected, "for_each(mask, 1 matrix)");
+		check(visited2, expected, "for_each(mask, 2 matrices)");
+		check(visited3, expected, "for_each(mask, 3 matrices)");
+		check(visited4, expected, "for_each(mask, 4 matrices)");
+	}
+
+	void TestForeachPair()
+	{
+		const unsigned char *mask = m_mask[0];
+		vector<pair<int, int>> expected, visited1, visited2, visited3, visited4;
+		int errors = 0;
+
+		his::for_each_pair(m_mats[0], [&](int a, int b)
+		{
+			if (mask[a] || mask[b])
+				expected.push_back(make_pair(a, b));
+		});
+
+		his::for_each_pair(m_runs, m_mats[0], [&](int a, int b)
+		{
+			visited1.push_back(make_pair(a, b));
+		});
+		his::for_each_pair(m_runs, m_mats[0], m_mats[1], [&](int a, int b, int a1, int b1)
+		{
+			errors += wrong(a, a1, 1) + wrong(b, b1, 1);
+			visited2.push_back(make_pair(a, b));
+		});
+		his::for_each_pair(m_runs, m_mats[0], m_mats[1], m_mats[2],
+			[&](int a, int b, int a1, int b1, int a2, int b2)
+		{
+			errors += wrong(a, a1, 1) + wrong(b, b1, 1) + wrong(a, a2, 2) + wrong(b, b2, 2);
+			visited3.push_back(make_pair(a, b));
+		});
+		his::for_each_pair(m_runs, m_mats[0], m_mats[1], m_mats[2], m_mats[3],
+			[&](int a, int b, int a1, int b1, int a2, int b2, int a3, int b3)
+		{
+			errors += wrong(a, a1, 1) + wrong(b, b1, 1) + wrong(a, a2, 2) + wrong(b, b2, 2)
+				+ wrong(a, a3, 3) + wrong(b, b3, 3);
+			visited4.push_back(make_pair(a, b));
+		});
+
+		if (errors > 0)
+			printf("Error %dx%d: masked for_each_pair mixed up %d elements\n",
+				m_mask.rows(), m_mask.cols(), errors);
+		check(visited1, expected, "for_each_pair(mask, 1 matrix)");
+		check(visited2, expected, "for_each_pair(mask, 2 matrices)");
+		check(visited3, expected, "for_each_pair(mask, 3 matrices)");
+		check(visited4, expected, "for_each_pair(mask, 4 matrices)");
+	}
+
+	his::Matrix<unsigned char> m_mask;
+	vector<his::Matrix<int>> m_mats;
+	his::RunLengthMask m_runs;
+	int m_n;
+};
+
+int main()
+{
+	// empty, sparse, half, dense and full masks, and degenerate shapes
+	const int percents[] = { -100, 10, 50, 90, 200 };
+	for (int p = 0; p < 5; ++p)
+	{
+		MaskTest(1, 1, percents[p]).Run();
+		MaskTest(1, 37, percents[p]).Run();
+		MaskTest(37, 1, percents[p]).Run();
+		MaskTest(64, 64, percents[p]).Run();
+		MaskTest(53, 97, percents[p]).Run();
+	}
+	return 0;
+}
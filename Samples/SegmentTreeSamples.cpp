@@ -1,11 +1,15 @@
 #include <stdio.h>
 
+#include <algorithm>
+#include <climits>
 #include <random>
 #include <string>
 #include <vector>
 using namespace std;
 
 #include "his/DataStructure/SegmentTree.hpp"
+#include "his/DataStructure/WideSegmentTree.hpp"
+#include "his/DataStructure/SparseTable.hpp"
 
 /*
 	Use SegmentTree for range summation on a vector<int>.
@@ -48,7 +52,7 @@ void TestSummation(size_t test_size)
 		{
 			int sum = segm_tree.query(i, j);
 			if (sum != segment_summation(i, j))
-				printf("Error [%d %d)\n", i, j);
+				printf("Error [%zu %zu)\n", i, j);
 		}
 	}
 }
@@ -61,8 +65,10 @@ void TestSummation(size_t test_size)
 	and the concatenation operation is noncommutative:
 	(a + b != b + a for string a and string b)
 	
-	This is just a sample, the query time is not O(logN) because
-	of the string copy cost.
+	The operation is given in place, appending to the accumulated 
+	string, so no temporary strings are created. The query result is
+	built into the same caller-owned string every time. The query 
+	time is still O(length) because of the output itself.
 */
 void TestStringConcatenation(size_t test_size)
 {
@@ -74,26 +80,158 @@ void TestStringConcatenation(size_t test_size)
 	
 	// for string concatenation the identity element is an empty string
 	his::SegmentTree<string> segm_tree(begin(long_string), end(long_string), "",
-		[](const string &a, const string &b)->string
+		[](string &acc, const string &rhs)
 	{
-		return a + b;
+		acc += rhs;
 	});
 
+	string substring;
 	for (size_t i = 0; i < long_string.size(); ++i)
 	{
 		for (size_t j = i; j <= long_string.size(); ++j)
 		{
-			string substring = segm_tree.query(i, j);
+			segm_tree.query(i, j, substring);
 			if (substring != long_string.substr(i, j-i))
-				printf("Error [%d %d)\n", i, j);
+				printf("Error [%zu %zu)\n", i, j);
 		}
 	}
 }
 
+/*
+	WideSegmentTree answers the same queries as SegmentTree with a
+	cache friendly B-ary layout. Passing the operation as a functor
+	type instead of std::function lets the compiler inline it.
+*/
+void TestWideSummation(size_t test_size)
+{
+	vector<int> values(test_size);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = rand() % 2000 - 1000;
+
+	his::SegmentTree<int> segm_tree(begin(values), end(values), 0,
+		[](int a, int b)->int { return a + b; });
+	his::WideSegmentTree<int, 4, std::plus<int>> wide_tree(begin(values), end(values), 0,
+		std::plus<int>());
+
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		for (size_t j = i; j <= values.size(); ++j)
+		{
+			if (wide_tree.query(i, j) != segm_tree.query(i, j))
+				printf("Error [%zu %zu)\n", i, j);
+		}
+	}
+}
+
+/*
+	Answer a batch of random range summations at once. The tree is 
+	read-only after construction, so the batch can be shared by
+	several threads (0 stands for all cores).
+*/
+void TestBatchSummation(size_t test_size, size_t queries)
+{
+	vector<int> values(test_size);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = rand() % 2000 - 1000;
+
+	his::SegmentTree<int> segm_tree(begin(values), end(values), 0,
+		[](int a, int b)->int { return a + b; }, 0);
+
+	vector<pair<size_t, size_t>> ranges(queries);
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		size_t a = rand() % (test_size + 1), b = rand() % (test_size + 1);
+		ranges[i] = make_pair(min(a, b), max(a, b));
+	}
+
+	vector<int> sums;
+	segm_tree.query_batch(ranges, sums, 0);
+
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		if (sums[i] != segm_tree.query(ranges[i].first, ranges[i].second))
+			printf("Error [%zu %zu)\n", ranges[i].first, ranges[i].second);
+	}
+}
+
+/*
+	The same on booleans: query_batch also fills a vector<bool>, whose
+	elements are packed in bits, from several threads.
+*/
+void TestBatchAny(size_t test_size, size_t queries)
+{
+	vector<bool> flags(test_size);
+	for (size_t i = 0; i < flags.size(); ++i)
+		flags[i] = rand() % 100 == 0;
+
+	his::SegmentTree<bool> segm_tree(begin(flags), end(flags), false,
+		[](bool a, bool b)->bool { return a || b; }, 0);
+
+	vector<pair<size_t, size_t>> ranges(queries);
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		size_t a = rand() % (test_size + 1), b = rand() % (test_size + 1);
+		ranges[i] = make_pair(min(a, b), max(a, b));
+	}
+
+	vector<bool> any;
+	segm_tree.query_batch(ranges, any, 0);
+
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		if (any[i] != segm_tree.query(ranges[i].first, ranges[i].second))
+			printf("Error [%zu %zu)\n", ranges[i].first, ranges[i].second);
+	}
+}
+
+/*
+	Range minimum with a SparseTable, which has the same interface as 
+	SegmentTree. Since min is idempotent, every query is answered with
+	two overlapping table lookups in O(1). The operation can be given
+	in place, and the build and the batches can use several threads.
+*/
+void TestSparseTableMinimum(size_t test_size, size_t queries)
+{
+	vector<int> values(test_size);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = rand() % 2000 - 1000;
+
+	auto min_op = [](int a, int b)->int { return min(a, b); };
+	his::SegmentTree<int> segm_tree(begin(values), end(values), INT_MAX, min_op);
+	his::SparseTable<int> sparse_table(begin(values), end(values), INT_MAX,
+		[](int &acc, const int &rhs) { acc = min(acc, rhs); }, 0);
+
+	for (size_t i = 0; i < values.size() && i < 100; ++i)
+	{
+		for (size_t j = i; j <= values.size() && j <= 100; ++j)
+		{
+			if (sparse_table.query(i, j) != segm_tree.query(i, j))
+				printf("Error [%zu %zu)\n", i, j);
+		}
+	}
+
+	vector<pair<size_t, size_t>> ranges(queries);
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		size_t a = rand() % (test_size + 1), b = rand() % (test_size + 1);
+		ranges[i] = make_pair(min(a, b), max(a, b));
+	}
+
+	vector<int> table_minima, tree_minima;
+	sparse_table.query_batch(ranges, table_minima, 0);
+	segm_tree.query_batch(ranges, tree_minima, 0);
+	if (table_minima != tree_minima)
+		printf("Error in the batch\n");
+}
+
 int main()
 {
 	TestSummation(100);
 	TestStringConcatenation(100);
+	TestWideSummation(100);
+	TestBatchSummation(100000, 10000);
+	TestBatchAny(100000, 10000);
+	TestSparseTableMinimum(100000, 10000);
 
 	return 0;
 }
\ No newline at end of file
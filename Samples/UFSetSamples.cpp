@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "his/DataStructure/ConcurrentUFSet.hpp"
+#include "his/DataStructure/UFSet.hpp"
+
+/*
+	A naive reference: every element keeps the id of its set, and a
+	merge relabels the whole smaller set.
+*/
+class ReferenceSets
+{
+public:
+	ReferenceSets(size_t size) : m_set(size)
+	{
+		for (size_t i = 0; i < size; ++i)
+			m_set[i] = int(i);
+	}
+
+	bool Merge(size_t id1, size_t id2)
+	{
+		int from = m_set[id2], to = m_set[id1];
+		if (from == to)
+			return false;
+		for (size_t i = 0; i < m_set.size(); ++i)
+			if (m_set[i] == from)
+				m_set[i] = to;
+		return true;
+	}
+
+	// dense labels in the order of the first element of each set
+	int Reduce(vector<int> &labels) const
+	{
+		vector<int> label_of_set(m_set.size(), -1);
+		int count = 0;
+		labels.resize(m_set.size());
+		for (size_t i = 0; i < m_set.size(); ++i)
+		{
+			if (label_of_set[m_set[i]] < 0)
+				label_of_set[m_set[i]] = count++;
+			labels[i] = label_of_set[m_set[i]];
+		}
+		return count;
+	}
+
+private:
+	vector<int> m_set;
+};
+
+/*
+	Random merges on a UFSet, compared with the reference: the result
+	of every Merge, then the labels after Reduce.
+*/
+void TestUFSet(size_t test_size, size_t merges)
+{
+	his::UFSet sets(test_size);
+	ReferenceSets reference(test_size);
+
+	for (size_t n = 0; n < merges; ++n)
+	{
+		size_t a = rand() % test_size, b = rand() % test_size;
+		if (sets.Merge(a, b) != reference.Merge(a, b))
+			printf("Error merging %zu %zu\n", a, b);
+		if (sets.Find(a) != sets.Find(b))
+			printf("Error finding %zu %zu\n", a, b);
+	}
+
+	vector<int> labels;
+	int count = reference.Reduce(labels);
+	if (sets.Reduce() != count)
+		printf("Error in the number of sets\n");
+	for (size_t i = 0; i < test_size; ++i)
+	{
+		if (sets.Query(i) != labels[i])
+			printf("Error label of %zu\n", i);
+	}
+}
+
+/*
+	The same merges shared by several threads on a ConcurrentUFSet.
+	Exactly one Merge per joined pair of sets returns true, whatever
+	the interleaving, and the labels of Reduce, with one thread or all
+	of them, are those of the reference.
+*/
+void TestConcurrentUFSet(size_t test_size, size_t merges, int threads)
+{
+	vector<pair<size_t, size_t>> pairs(merges);
+	for (size_t n = 0; n < merges; ++n)
+		pairs[n] = make_pair(rand() % test_size, rand() % test_size);
+
+	ReferenceSets reference(test_size);
+	for (size_t n = 0; n < merges; ++n)
+		reference.Merge(pairs[n].first, pairs[n].second);
+	vector<int> labels;
+	int count = reference.Reduce(labels);
+
+	for (int reduce_threads : { 1, 0 })
+	{
+		his::ConcurrentUFSet sets(test_size);
+		atomic<size_t> joined(0);
+
+		// thread t takes the merges t, t + threads, ...
+		vector<thread> workers;
+		for (int t = 0; t < threads; ++t)
+			workers.push_back(thread([&, t]()
+		{
+			for (size_t n = t; n < merges; n += threads)
+			{
+				if (sets.Merge(pairs[n].first, pairs[n].second))
+					joined++;
+				if (sets.Find(pairs[n].first) != sets.Find(pairs[n].second))
+					printf("Error finding %zu %zu\n", pairs[n].first, pairs[n].second);
+			}
+		}));
+		for (auto &worker : workers)
+			worker.join();
+
+		if (joined != test_size - size_t(count))
+			printf("Error in the number of merges\n");
+		if (sets.Reduce(reduce_threads) != count)
+			printf("Error in the number of sets\n");
+		for (size_t i = 0; i < test_size; ++i)
+		{
+			if (sets.Query(i) != labels[i])
+				printf("Error label of %zu\n", i);
+		}
+	}
+}
+
+int main()
+{
+	for (size_t merges : { 0, 10, 500, 1500, 5000 })
+		TestUFSet(2000, merges);
+
+	for (int threads : { 1, 2, 4, 8 })
+		for (size_t merges : { 10, 1500, 100000 })
+			TestConcurrentUFSet(2000, merges, threads);
+
+	return 0;
+}